@@ -40,7 +40,7 @@ pushd %project_root%
     rmdir /s /q bin
 
     if %release%==0 (
-      .\%exe_name% ..\data bin --serve
+      .\%exe_name% ..\data bin --serve --watch
     )
     if %release%==1 (
       .\%exe_name% ..\data bin --open
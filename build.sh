@@ -9,6 +9,9 @@ publish_path="$project_root..\nickav.github.io"
 
 flags="-std=c++11 -Wno-deprecated-declarations -Wno-int-to-void-pointer-cast -Wno-writable-strings -Wno-dangling-else -Wno-switch -Wno-undefined-internal"
 libs=""
+[[ "$(uname)" == "Darwin" ]] && libs="-framework CoreServices" # file watcher
+[[ "$(uname)" == "Linux" ]] && libs="-lpthread"
+[[ "$(uname -m)" == "x86_64" ]] && flags="$flags -maes" # AES asset hash in helpers.h
 
 # Args
 release=0
@@ -26,7 +29,7 @@ pushd $project_root
     rm -rf bin
 
     if [[ $release == 0 ]]; then
-      ./$exe_name ../data bin --serve
+      ./$exe_name ../data bin --serve --watch
     fi
     if [[ $release == 1 ]]; then
       ./$exe_name ../data bin --open
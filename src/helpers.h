@@ -6,6 +6,34 @@ void string_advance(String *str, i64 amount)
     str->count -= amount;
 }
 
+String string_trim_newlines(String str)
+{
+    while (str.count > 0 && (str.data[0] == '\n' || str.data[0] == '\r'))
+    {
+        string_advance(&str, 1);
+    }
+    while (str.count > 0 && (str.data[str.count - 1] == '\n' || str.data[str.count - 1] == '\r'))
+    {
+        str.count -= 1;
+    }
+    return str;
+}
+
+// NOTE(nick): arena_push would align the position first and leave gaps between the pieces of a string
+bool arena_write(Arena *arena, String str)
+{
+    u8 *data = (u8 *)arena_push_bytes(arena, str.count);
+    if (data && str.count > 0) MemoryCopy(data, str.data, str.count);
+    return data != NULL;
+}
+
+// NOTE(nick): everything that was written to the arena since it was reset, only works if all of it
+// went through arena_write or write
+String arena_to_string(Arena *arena)
+{
+    return string_make(arena->data, arena->pos);
+}
+
 String string_from_month(Month month)
 {
     static String string_table[] = {
@@ -34,6 +62,8 @@ String string_from_month(Month month)
 
 String minify_css(String str)
 {
+    static Char_Set special_chars = char_set_make(S("/\r\n\"' {>}"));
+
     u8 *data = PushArray(temp_arena(), u8, str.count);
     u8 *at = data;
     u8 *end = data + str.count;
@@ -41,6 +71,17 @@ String minify_css(String str)
     bool did_write_char = false;
     while (str.count)
     {
+        // NOTE(nick): copy everything up to the next character we care about in one go
+        if (!char_set_contains(&special_chars, str.data[0]))
+        {
+            i64 run = string_find_char_set(str, &special_chars, 1);
+            MemoryCopy(at, str.data, run);
+            at += run;
+            string_advance(&str, run);
+            did_write_char = true;
+            continue;
+        }
+
         char it = str[0];
 
         // NOTE(nick): eat comments
@@ -153,6 +194,8 @@ String minify_css(String str)
 
 String minify_js(String str)
 {
+    static Char_Set special_chars = char_set_make(S("\r\n "));
+
     u8 *data = PushArray(temp_arena(), u8, str.count);
     u8 *at = data;
     u8 *end = data + str.count;
@@ -160,6 +203,17 @@ String minify_js(String str)
     bool did_write_char = false;
     while (str.count)
     {
+        // NOTE(nick): copy everything up to the next character we care about in one go
+        if (!char_set_contains(&special_chars, str.data[0]))
+        {
+            i64 run = string_find_char_set(str, &special_chars, 1);
+            MemoryCopy(at, str.data, run);
+            at += run;
+            string_advance(&str, run);
+            did_write_char = true;
+            continue;
+        }
+
         char it = str[0];
 
         if (it == '\r' || it == '\n')
@@ -287,12 +341,92 @@ String pretty_date(Date_Time it)
 
 void write(Arena *arena, char *format, ...)
 {
+    M_Temp scratch = GetScratch(&arena, 1);
+
     va_list args;
     va_start(args, format);
-    string_printv(arena, format, args);
+    String str = string_printv(scratch.arena, format, args);
     va_end(args);
+
+    arena_write(arena, str);
+    ReleaseScratch(scratch);
 }
 
+// NOTE(nick): written next to the old file and renamed over it, so anything that has the old file open
+// keeps reading the old bytes instead of a half written file
+bool replace_entire_file(String path, String contents)
+{
+    auto temp_path = sprint("%S.tmp", path);
+    if (!os_write_entire_file(temp_path, contents)) return false;
+
+    // NOTE(nick): MoveFileW doesn't replace files that already exist
+    if (os_file_rename(temp_path, path)) return true;
+
+    os_delete_file(path);
+    return os_file_rename(temp_path, path);
+}
+
+bool make_directory_recursive(String path)
+{
+    if (!path.count || os_directory_exists(path)) return true;
+
+    auto parent = path_basename(path);
+    if (parent.count < path.count) make_directory_recursive(parent);
+
+    return os_make_directory(path);
+}
+
+// NOTE(nick): every file under path (not the directories), named relative to it and linked through next
+// Hidden files are skipped.
+File_Info *scan_files_recursive(Arena *arena, String path)
+{
+    File_Info *first = NULL;
+    File_Info *last  = NULL;
+
+    // NOTE(nick): directories left to scan, relative to path, they are appended while we walk the list
+    String_List dirs = {};
+    string_list_push(arena, &dirs, S(""));
+
+    for (String_Node *dir = dirs.first; dir; dir = dir->next)
+    {
+        auto dir_path = dir->string.count ? path_join(path, dir->string) : path;
+        auto iter = os_file_iter_begin(arena, dir_path);
+
+        File_Info info = {};
+        while (os_file_iter_next(arena, iter, &info))
+        {
+            if (string_starts_with(info.name, S("."))) continue;
+
+            auto name = dir->string.count ? string_print(arena, "%S/%S", dir->string, info.name) : info.name;
+
+            if (os_file_is_directory(info))
+            {
+                string_list_push(arena, &dirs, name);
+                continue;
+            }
+
+            File_Info *file = PushStruct(arena, File_Info);
+            *file = info;
+            file->name = name;
+            file->next = NULL;
+            QueuePush(first, last, file);
+        }
+
+        os_file_iter_end(iter);
+    }
+
+    return first;
+}
+
+// NOTE(nick): the AES hash only exists on x64, MSVC always has the instructions, everyone else has to build
+// with -maes (see build.sh)
+#if ARCH_X64 && (COMPILER_MSVC || defined(__AES__))
+#define HAS_ASSET_HASH 1
+
+#if !COMPILER_MSVC
+#include <wmmintrin.h>
+#endif
+
 static char unsigned OverhangMask[32] =
 {
     255, 255, 255, 255,  255, 255, 255, 255,  255, 255, 255, 255,  255, 255, 255, 255,
@@ -379,4 +513,6 @@ static bool AssetHashesAreEqual(Asset_Hash a, Asset_Hash b)
     __m128i compare = _mm_cmpeq_epi32(a.value, b.value);
     int result = _mm_movemask_epi8(compare) == 0xffff;
     return result;
-}
\ No newline at end of file
+}
+
+#endif // HAS_ASSET_HASH
\ No newline at end of file
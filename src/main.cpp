@@ -3,6 +3,33 @@
 #define STB_SPRINTF_IMPLEMENTATION
 #include "third_party/stb_sprintf.h"
 
+// NOTE(nick): na.h formats everything with this, so %S works in string_print and print
+#define PrintToBuffer stbsp_vsnprintf
+
+static char *print_callback(const char *buffer, void *user, int count)
+{
+    fwrite(buffer, 1, count, stdout);
+    return (char *)buffer;
+}
+
+void print(const char *format, ...)
+{
+    char buffer[STB_SPRINTF_MIN];
+
+    va_list args;
+    va_start(args, format);
+    stbsp_vsprintfcb(print_callback, NULL, buffer, format, args);
+    va_end(args);
+
+    fflush(stdout);
+}
+
+// NOTE(nick): only used for its deflate encoder (stbi_zlib_compress)
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#define STB_IMAGE_WRITE_STATIC
+#define STBI_WRITE_NO_STDIO
+#include "third_party/stb_image_write.h"
+
 #include "na.h"
 #define impl
 #include "na_net.h"
@@ -48,15 +75,164 @@ struct Page_Meta
     bool draft;
 };
 
+struct Dependency
+{
+    String key;
+    u64 hash;
+};
+
+struct Dependency_Node
+{
+    Dependency *dep;
+    u64 hash;         // the value of dep when it was read
+    Dependency_Node *next;
+};
+
+// NOTE(nick): the html for the markdown part of a page, see render_page_body
+struct Markdown_Cache_Entry
+{
+    u64 hash;              // hash of the markdown source
+    String html;
+    i64 words;             // see Markdown_Doc
+    Dependency_Node *deps; // what the custom tags read while it was rendered
+    bool owned;            // rendered in this run and freed with its page, see free_markdown_cache_entry
+
+    Markdown_Cache_Entry *next;
+};
+
+struct Markdown_Cache
+{
+    Markdown_Cache_Entry *first;
+    Markdown_Cache_Entry *last;
+    i64 count;
+
+    Table_KV index;
+};
+
 struct Page
 {
     Page_Meta meta;
     String slug;
     String content;
     String type;
+    String source;    // the whole file, owned by the page (content and meta point into it)
 
-    Page *next;
-    Page *prev;
+    String path;      // source file, relative to the data dir
+    u64 hash;         // hash of the whole source file
+    u64 meta_hash;    // hash of the yaml frontmatter
+    bool up_to_date;
+
+    bool rendered;    // deps and rendered_hash are from the last time the page was written
+    u64 rendered_hash;
+    Dependency_Node *deps;      // owned by the page, see copy_dependency_list
+    Markdown_Cache_Entry *body;
+
+    // NOTE(nick): closest published neighbours by date (drafts get them too), indices into ctx.pages or -1
+    i64 prev_index;
+    i64 next_index;
+};
+
+// NOTE(nick): the published pages of a type sorted by date, every page is only stored once in ctx.pages
+struct Page_View
+{
+    i64 *indices; // into ctx.pages
+    i64 count;
+};
+
+struct Manifest_Entry
+{
+    String input;
+    u64 hash;
+    u64 size;
+    Dense_Time updated_at;
+
+    String_List outputs;
+    Dependency_Node *deps;
+
+    Manifest_Entry *next;
+    Manifest_Entry *prev;
+};
+
+struct Build_Manifest
+{
+    Manifest_Entry *first;
+    Manifest_Entry *last;
+    i64 count;
+
+    Table_KV index;
+    Arena *arenas[2]; // entries are in the first one, see manifest_compact
+};
+
+// NOTE(nick): a file from the data dir that gets pasted into the output (e.g. social icons)
+struct Included_File
+{
+    String path;    // relative to the data dir
+    String content;
+    u64 hash;
+    bool loaded;
+};
+
+typedef u32 Asset_Mode;
+enum {
+    AssetMode_Auto = 0, // see asset_should_be_inlined
+    AssetMode_Inline,
+    AssetMode_External,
+};
+
+typedef u32 Page_Slot;
+enum {
+    PageSlot_None = 0,
+    PageSlot_Title,
+    PageSlot_Description,
+    PageSlot_Image,
+    PageSlot_Og_Type,
+    PageSlot_Url,
+    PageSlot_Styles,  // only with --critical-css
+    PageSlot_Content,
+
+    PageSlot_COUNT,
+};
+
+struct Page_Shell_Segment
+{
+    String text;    // static bytes, the same for every page
+    Page_Slot slot; // what gets written after them
+};
+
+#define PAGE_SHELL_MAX_SEGMENTS 32
+
+// NOTE(nick): see compile_page_shell
+struct Page_Shell
+{
+    Page_Shell_Segment segments[PAGE_SHELL_MAX_SEGMENTS];
+    i64 count;
+
+    u64 mark;         // end of the last segment in the arena
+    Arena *arena;     // only holds the segments, so they're all in one piece
+
+    String_List deps; // keys every page reads through the shell
+    Arena *deps_arena;
+
+    Table_KV classes; // every class name used by the shell or the scripts, for critical css
+};
+
+// NOTE(nick): a style rule (or an at-rule we don't look into) from the minified css
+struct Css_Rule
+{
+    String text;     // selectors and block, exactly as they are in ctx.css
+    String media;    // prelude of the @media block it's in, if any
+    bool always;     // doesn't depend on any classes
+
+    u64 *classes;    // hashes of the classes each selector needs, with a 0 after every selector
+    i64 class_count;
+};
+
+struct Css_Index
+{
+    Css_Rule *rules;
+    i64 count;
+
+    Arena *arena;
 };
 
 struct Build_Context
@@ -64,16 +240,45 @@ struct Build_Context
     String data_dir;
     String output_dir;
 
+    Build_Manifest prev_manifest;
+    Build_Manifest manifest;
+
+    Markdown_Cache prev_markdown_cache;
+
+    Table_KV dependencies;
+    Arena *dependency_arena;
+
     Site_Meta site;
+    Arena *site_arena; // reset every time site.yaml is loaded
+
+    Table_KV included_files;
+    Arena *included_files_arena;
+
+    String css; // css and js are owned, see load_styles
+    String js;
+    String rss_feed;
+
+    Asset_Mode asset_mode;
+    bool critical_css; // every page only inlines the css rules it uses, see write_critical_css
+    Css_Index css_index;
 
+    String css_file; // when set, pages link to this file in the output dir instead of inlining the css
+    String js_file;
+
+    bool live_reload; // pages include a script that reloads them when they are rebuilt
+
+    Page_Shell shell;
+
+    // NOTE(nick): see load_pages
     Page *pages;
-    Page *last_page;
+    i64 page_count;
+    Arena *pages_arenas[2];
 
-    Page *posts;
-    Page *last_post;
+    Page_View posts;
+    Page_View projects;
 
-    Page *projects;
-    Page *last_project;
+    Table_KV pages_by_path;
+    Table_KV authors_by_title;
 };
 
 struct Next_Prev_Pages
@@ -86,7 +291,7 @@ struct Next_Prev_Pages
 
 #define Each_Node_Reverse(it, list) auto *it = list; it != NULL; it = it->prev
 
-#define Each_Page(it, list) Page *it = list; it != NULL; it = it->next
+#define Each_Page(it) Page *it = ctx.pages; it < ctx.pages + ctx.page_count; it += 1
 
 #define Each_Link(it, list) Link *it = list; it != NULL; it = it->next
 
@@ -110,7 +315,7 @@ String yaml_to_string(String str) {
     return str;
 }
 
-Link *parse_yaml_links_array(String str)
+Link *parse_yaml_links_array(Arena *arena, String str)
 {
     Link *result = NULL;
     Link *last = NULL;
@@ -134,19 +339,18 @@ Link *parse_yaml_links_array(String str)
 
         if (depth == 2)
         {
-            i64 closing_index = string_find(str, S("]"), i + 1);
+            i64 closing_index = string_find(str, S("]"), i + 1, 0);
             auto list = string_slice(str, i, closing_index + 1);
 
             auto str = string_trim_whitespace(string_slice(list, 1, list.count - 1));
-            auto parts = string_split(str, S(","));
-            if (parts.count > 0)
-            {
-                Link *item = PushStruct(temp_arena(), Link);
-                if (parts.count > 0) item->title = PushStringCopy(temp_arena(), yaml_to_string(parts[0]));
-                if (parts.count > 1) item->href  = PushStringCopy(temp_arena(), yaml_to_string(parts[1]));
-                if (parts.count > 2) item->desc  = PushStringCopy(temp_arena(), yaml_to_string(parts[2]));
-                QueuePush(result, last, item);
-            }
+            auto parts = string_split_begin(str, S(","));
+
+            Link *item = PushStructZero(arena, Link);
+            String part = {};
+            if (string_split_next(&parts, &part)) item->title = PushStringCopy(arena, yaml_to_string(part));
+            if (string_split_next(&parts, &part)) item->href  = PushStringCopy(arena, yaml_to_string(part));
+            if (string_split_next(&parts, &part)) item->desc  = PushStringCopy(arena, yaml_to_string(part));
+            QueuePush(result, last, item);
 
             i += list.count - 1;
             depth -= 1;
@@ -157,25 +361,21 @@ Link *parse_yaml_links_array(String str)
 }
 
 
-Site_Meta parse_site_info(String yaml)
+Site_Meta parse_site_info(Arena *arena, String yaml)
 {
     Site_Meta result = {};
 
-    i64 offset = 0;
-    auto lines = string_split(yaml, S("\n"));
-    For_Index (lines)
+    auto lines = string_lines_begin(yaml);
+    String it = {};
+    while (string_split_next(&lines, &it))
     {
-        auto it = lines[index];
+        i64 offset = it.data - yaml.data;
 
-        i64 colon_index = string_find(it, S(":"));
-        if (colon_index >= it.count)
-        {
-            offset += it.count + 1;
-            continue;
-        }
+        i64 colon_index = string_find(it, S(":"), 0, 0);
+        if (colon_index >= it.count) continue;
 
         auto key   = string_trim_whitespace(string_slice(it, 0, colon_index));
-        auto value = string_trim_whitespace(string_slice(it, colon_index + 1));
+        auto value = string_trim_whitespace(string_skip(it, colon_index + 1));
 
         auto str = yaml_to_string(value);
 
@@ -192,16 +392,14 @@ Site_Meta parse_site_info(String yaml)
         else if (string_equals(key, S("og_type")))        { result.og_type = str; } 
 
         else if (string_equals(key, S("social_icons"))) {
-            result.social_icons = parse_yaml_links_array(string_slice(yaml, offset + colon_index + 1));
+            result.social_icons = parse_yaml_links_array(arena, string_skip(yaml, offset + colon_index + 1));
         }
         else if (string_equals(key, S("author_links"))) {
-            result.authors = parse_yaml_links_array(string_slice(yaml, offset + colon_index + 1));
+            result.authors = parse_yaml_links_array(arena, string_skip(yaml, offset + colon_index + 1));
         }
         else if (string_equals(key, S("featured_links"))) {
-            result.featured = parse_yaml_links_array(string_slice(yaml, offset + colon_index + 1));
+            result.featured = parse_yaml_links_array(arena, string_skip(yaml, offset + colon_index + 1));
         }
-
-        offset += it.count + 1;
     }
 
     return result;
@@ -210,14 +408,15 @@ Site_Meta parse_site_info(String yaml)
 Page_Meta parse_page_meta(String yaml) {
     Page_Meta result = {};
 
-    auto lines = string_split(yaml, S("\n"));
-    For (lines)
+    auto lines = string_lines_begin(yaml);
+    String it = {};
+    while (string_split_next(&lines, &it))
     {
-        i64 index = string_find(it, S(":"));
+        i64 index = string_find(it, S(":"), 0, 0);
         if (index >= it.count) continue;
 
         auto key   = string_trim_whitespace(string_slice(it, 0, index));
-        auto value = string_trim_whitespace(string_slice(it, index + 1));
+        auto value = string_trim_whitespace(string_skip(it, index + 1));
 
         auto str = yaml_to_string(value);
 
@@ -229,7 +428,7 @@ Page_Meta parse_page_meta(String yaml) {
                     string_equals(key, S("description"))) { result.description = str; }
         else if (string_equals(key, S("date")))           { result.date = str; }
         else if (string_equals(key, S("author")))         { result.author = str; }
-        else if (string_equals(key, S("draft")))          { result.draft = string_to_bool(value); }
+        else if (string_equals(key, S("draft")))          { result.draft = string_to_b32(value); }
     }
 
     return result;
@@ -254,27 +453,67 @@ String post_link(Page *post)
     return {};
 }
 
-Page *find_page_by_slug(Page *page, Page *array)
+//
+// Lookup Tables
+//
+// Pages (by path) and author links (by title) are found through tables that are filled in
+// once after loading, instead of walking the lists for every page we render.
+//
+
+struct Lookup_Entry
+{
+    String key;
+    void *value;
+};
+
+void lookup_reset(Table_KV *table)
+{
+    if (!table->slots) table_init(table, sizeof(u64), sizeof(Lookup_Entry));
+    table_reset(table);
+}
+
+void *lookup_find(Table_KV *table, String key)
 {
-    for (Each_Node(it, array))
+    if (!table->slots) return NULL;
+
+    u64 hash = murmur64_from_string(key);
+    Lookup_Entry *result = (Lookup_Entry *)table_get(table, table_hash_make(hash), &hash);
+
+    if (result && string_equals(result->key, key))
     {
-        if (string_equals(it->slug, page->slug)) return it;
+        return result->value;
     }
+
     return NULL;
 }
 
-Next_Prev_Pages find_next_and_prev_pages(Page *page)
+// NOTE(nick): the first value with a key wins, same as a search from the front of the list would
+void lookup_add(Table_KV *table, String key, void *value)
 {
-    Next_Prev_Pages result = {};
+    u64 hash = murmur64_from_string(key);
+    if (table_get(table, table_hash_make(hash), &hash)) return;
+
+    Lookup_Entry entry = {};
+    entry.key   = key;
+    entry.value = value;
+    table_add(table, table_hash_make(hash), &hash, &entry);
+}
 
-    Page *next = page->next;
-    Page *prev = page->prev;
+Page *page_view_get(Page_View *view, i64 index)
+{
+    return &ctx.pages[view->indices[index]];
+}
 
-    while (next && next->meta.draft) next = next->next;
-    while (prev && prev->meta.draft) prev = prev->prev;
+Page *page_from_index(i64 index)
+{
+    return index >= 0 ? &ctx.pages[index] : NULL;
+}
 
-    result.next = next;
-    result.prev = prev;
+Next_Prev_Pages find_next_and_prev_pages(Page *page)
+{
+    Next_Prev_Pages result = {};
+    result.next = page_from_index(page->next_index);
+    result.prev = page_from_index(page->prev_index);
     return result;
 }
 
@@ -284,30 +523,352 @@ Next_Prev_Pages find_next_and_prev_pages_by_type(Page *page)
 
     String type = page->type;
 
-    Page *next = page->next;
-    Page *prev = page->prev;
+    // NOTE(nick): neighbours in the order the pages were loaded in
+    Page *end = ctx.pages + ctx.page_count;
+    Page *next = page + 1 < end ? page + 1 : NULL;
+    Page *prev = page > ctx.pages ? page - 1 : NULL;
 
-    while (next && (!string_equals(type, next->type) || next->meta.draft)) next = next->next;
-    while (prev && (!string_equals(type, prev->type) || prev->meta.draft)) prev = prev->next;
+    while (next && (!string_equals(type, next->type) || next->meta.draft)) next = next + 1 < end ? next + 1 : NULL;
+    while (prev && (!string_equals(type, prev->type) || prev->meta.draft)) prev = prev > ctx.pages ? prev - 1 : NULL;
 
     result.next = next;
     result.prev = prev;
     return result;
 }
 
-Link *find_link_by_title(String title, Link *links)
+Link *find_link_by_title(String title, Table_KV *links_by_title)
+{
+    return (Link *)lookup_find(links_by_title, title);
+}
+
+//
+// Dependencies
+//
+// Every piece of data a page can read besides its own source file has a key
+// (e.g. "meta:posts/0001_hello_world", "site:name", "file:icons/github.svg") and a hash
+// of its current value. While a page renders we record the keys it reads, so the next
+// build only has to re-render pages where one of those hashes changed.
+//
+//   site:<field>  a field from site.yaml
+//   file:<path>   a file in the data dir (styles, scripts, icons)
+//   meta:<slug>   the frontmatter of another page
+//   list:<type>   which pages of a type exist and in what order
+//   nav:<slug>    the prev / next links of a post or project
+//   build:<flag>  a command line option that changes the output
+//
+
+u64 content_hash(String str)
+{
+    return murmur64(str.data, str.count);
+}
+
+u64 content_hash(u64 seed, String str)
+{
+    return murmur64_seed(str.data, str.count, seed);
+}
+
+Dependency *dependency_find(String key)
+{
+    if (!ctx.dependencies.slots) return NULL;
+
+    u64 hash = content_hash(key);
+    Dependency **result = (Dependency **)table_get(&ctx.dependencies, table_hash_make(hash), &hash);
+
+    if (result && string_equals((*result)->key, key))
+    {
+        return *result;
+    }
+
+    return NULL;
+}
+
+// NOTE(nick): dependencies are never removed, pages keep pointers to them between builds
+void dependency_set(String key, u64 value)
+{
+    if (!ctx.dependencies.slots) table_init(&ctx.dependencies, sizeof(u64), sizeof(Dependency *));
+    if (!ctx.dependency_arena) ctx.dependency_arena = arena_alloc(Megabytes(64));
+
+    Dependency *dep = dependency_find(key);
+    if (!dep)
+    {
+        dep = PushStructZero(ctx.dependency_arena, Dependency);
+        dep->key = PushStringCopy(ctx.dependency_arena, key);
+
+        u64 hash = content_hash(key);
+        table_add(&ctx.dependencies, table_hash_make(hash), &hash, &dep);
+    }
+
+    dep->hash = value;
+}
+
+u64 links_hash(Link *links)
 {
+    u64 result = 0;
     for (Each_Link(it, links))
     {
-        if (string_equals(it->title, title)) return it;
+        result = content_hash(result, it->title);
+        result = content_hash(result, it->href);
+        result = content_hash(result, it->desc);
+    }
+    return result;
+}
+
+u64 page_view_hash(Page_View *view)
+{
+    u64 result = 0;
+    for (i64 i = 0; i < view->count; i += 1)
+    {
+        result = content_hash(result, page_view_get(view, i)->slug);
+    }
+    return result;
+}
+
+u64 next_and_prev_hash(Page *page)
+{
+    auto links = find_next_and_prev_pages(page);
+
+    u64 result = 0;
+    result = content_hash(result, links.prev ? links.prev->slug : S(""));
+    result = content_hash(result, links.next ? links.next->slug : S(""));
+    return result;
+}
+
+//
+// Included Files
+//
+// Files that get inlined into pages are read once and kept around for every build after that.
+// The watcher calls invalidate_included_file when one changes, so it's read again on next use.
+//
+
+Included_File *find_included_file(String path)
+{
+    if (!ctx.included_files.slots) return NULL;
+
+    u64 hash = content_hash(path);
+    Included_File **result = (Included_File **)table_get(&ctx.included_files, table_hash_make(hash), &hash);
+
+    if (result && string_equals((*result)->path, path))
+    {
+        return *result;
     }
+
     return NULL;
 }
 
+// NOTE(nick): only called from the main thread, pages get the contents through the page shell
+Included_File *include_file(String path)
+{
+    if (!ctx.included_files.slots) table_init(&ctx.included_files, sizeof(u64), sizeof(Included_File *));
+    if (!ctx.included_files_arena) ctx.included_files_arena = arena_alloc(Megabytes(64));
+
+    Included_File *file = find_included_file(path);
+    if (!file)
+    {
+        file = PushStructZero(ctx.included_files_arena, Included_File);
+        file->path = PushStringCopy(ctx.included_files_arena, path);
+
+        u64 hash = content_hash(path);
+        table_add(&ctx.included_files, table_hash_make(hash), &hash, &file);
+    }
+
+    if (!file->loaded)
+    {
+        String content = os_read_entire_file(temp_arena(), path_join(ctx.data_dir, path));
+        string_free(&file->content);
+        file->content = string_alloc(content);
+        file->hash    = content_hash(file->content);
+        file->loaded  = true;
+    }
+
+    return file;
+}
+
+void invalidate_included_file(String path)
+{
+    Included_File *file = find_included_file(path);
+    if (file) file->loaded = false;
+}
+
+void invalidate_included_files()
+{
+    for (i64 index = 0; index < ctx.included_files.capacity; index += 1)
+    {
+        if (ctx.included_files.slots[index].hash.value < TABLE_FIRST_VALID_HASH) continue;
+
+        Included_File *file = *(Included_File **)table_value(&ctx.included_files, index);
+        file->loaded = false;
+    }
+}
+
+// NOTE(nick): must be called (on the main thread) after all of the data files are loaded and
+// before any pages are rendered, rendering only ever reads from this table
+void build_dependency_table()
+{
+    M_Temp temp = arena_begin_temp(temp_arena());
+
+    // NOTE(nick): anything that isn't set again below no longer exists (e.g. a deleted page)
+    for (i64 index = 0; index < ctx.dependencies.capacity; index += 1)
+    {
+        if (ctx.dependencies.slots[index].hash.value < TABLE_FIRST_VALID_HASH) continue;
+
+        Dependency *dep = *(Dependency **)table_value(&ctx.dependencies, index);
+        dep->hash = 0;
+    }
+
+    auto site = ctx.site;
+
+    dependency_set(S("site:name"),           content_hash(site.name));
+    dependency_set(S("site:url"),            content_hash(site.url));
+    dependency_set(S("site:image"),          content_hash(site.image));
+    dependency_set(S("site:icon"),           content_hash(site.icon));
+    dependency_set(S("site:description"),    content_hash(site.description));
+    dependency_set(S("site:author"),         content_hash(site.author));
+    dependency_set(S("site:twitter_handle"), content_hash(site.twitter_handle));
+    dependency_set(S("site:theme_color"),    content_hash(site.theme_color));
+    dependency_set(S("site:og_type"),        content_hash(site.og_type));
+    dependency_set(S("site:social_icons"),   links_hash(site.social_icons));
+    dependency_set(S("site:author_links"),   links_hash(site.authors));
+    dependency_set(S("site:featured_links"), links_hash(site.featured));
+
+    dependency_set(S("build:live_reload"), ctx.live_reload);
+    dependency_set(S("build:assets"), (ctx.css_file.count ? 1 : 0) | (ctx.js_file.count ? 2 : 0) | (ctx.critical_css ? 4 : 0));
+
+    dependency_set(S("file:style.css"), content_hash(ctx.css));
+    dependency_set(S("file:script.js"), content_hash(ctx.js));
+
+    for (Each_Link(it, site.social_icons))
+    {
+        dependency_set(sprint("file:%S", it->desc), include_file(it->desc)->hash);
+    }
+
+    for (Each_Page(it))
+    {
+        dependency_set(sprint("meta:%S", it->slug), it->meta_hash);
+    }
+
+    dependency_set(S("list:post"),    page_view_hash(&ctx.posts));
+    dependency_set(S("list:project"), page_view_hash(&ctx.projects));
+
+    for (Each_Page(it))
+    {
+        dependency_set(sprint("nav:%S", it->slug), next_and_prev_hash(it));
+    }
+
+    arena_end_temp(temp);
+}
+
+thread_local Page *recording_page = NULL;
+thread_local Table_KV recorded_deps = {};
+thread_local Dependency_Node *recorded_list = NULL;
+
+// NOTE(nick): scratch for the lists that are built while a page is written, see reset_dependency_scratch
+thread_local Arena *deps_arena = NULL;
+
+// NOTE(nick): the markdown cache needs the deps of a page body on their own (including ones the page already read)
+thread_local bool capturing_deps = false;
+thread_local Dependency_Node *captured_deps = NULL;
+
+Dependency_Node *push_dependency_node(Dependency_Node *list, Dependency *dep, u64 hash)
+{
+    if (!deps_arena) deps_arena = arena_alloc(Megabytes(64));
+
+    Dependency_Node *node = PushStructZero(deps_arena, Dependency_Node);
+    node->dep  = dep;
+    node->hash = hash;
+    node->next = list;
+    return node;
+}
+
+// NOTE(nick): only lists that were copied out with copy_dependency_list outlive the page being written
+void reset_dependency_scratch()
+{
+    if (deps_arena) arena_reset(deps_arena);
+}
+
+// NOTE(nick): pages and markdown cache entries keep their own copy, all of the nodes are in one block
+Dependency_Node *copy_dependency_list(Dependency_Node *list)
+{
+    i64 count = 0;
+    for (Each_Node(node, list)) count += 1;
+    if (!count) return NULL;
+
+    Dependency_Node *result = (Dependency_Node *)os_alloc(sizeof(Dependency_Node) * count);
+
+    i64 index = 0;
+    for (Each_Node(node, list))
+    {
+        result[index] = *node;
+        result[index].next = index + 1 < count ? &result[index + 1] : NULL;
+        index += 1;
+    }
+
+    return result;
+}
+
+void free_dependency_list(Dependency_Node **list)
+{
+    if (*list) os_free(*list);
+    *list = NULL;
+}
+
+void begin_recording_dependencies(Page *page)
+{
+    if (!recorded_deps.slots) table_init(&recorded_deps, sizeof(Dependency *), sizeof(bool));
+
+    table_reset(&recorded_deps);
+    recorded_list  = NULL;
+    recording_page = page;
+}
+
+void end_recording_dependencies()
+{
+    Page *page = recording_page;
+
+    free_dependency_list(&page->deps);
+    page->deps = copy_dependency_list(recorded_list);
+
+    recorded_list  = NULL;
+    recording_page = NULL;
+}
+
+void depend_on(String key)
+{
+    Page *page = recording_page;
+    if (!page) return;
+
+    // NOTE(nick): every key a page can read is put in the table up front by build_dependency_table
+    Dependency *dep = dependency_find(key);
+    assert(dep);
+    if (!dep) return;
+
+    if (capturing_deps)
+    {
+        bool captured = false;
+        for (Each_Node(node, captured_deps))
+        {
+            if (node->dep == dep) { captured = true; break; }
+        }
+
+        if (!captured) captured_deps = push_dependency_node(captured_deps, dep, dep->hash);
+    }
+
+    H_Hash hash = table_hash_i64((i64)dep);
+    if (table_get(&recorded_deps, hash, &dep)) return;
+
+    bool recorded = true;
+    table_add(&recorded_deps, hash, &dep, &recorded);
+
+    recorded_list = push_dependency_node(recorded_list, dep, dep->hash);
+}
+
 
-String generate_blog_rss_feed(Site_Meta site, Page *posts)
+String generate_blog_rss_feed(Site_Meta site, Page_View *posts)
 {
-    auto arena = arena_alloc_from_memory(megabytes(32));
+    // NOTE(nick): the feed is kept in ctx.rss_feed until the next time it's generated
+    static Arena *arena = NULL;
+    if (!arena) arena = arena_alloc(Megabytes(32));
+    arena_reset(arena);
+
     auto pub_date = to_rss_date_string(os_get_current_time_in_utc());
 
     write(arena, "<?xml version='1.0' encoding='UTF-8'?>\n");
@@ -325,9 +886,9 @@ String generate_blog_rss_feed(Site_Meta site, Page *posts)
     write(arena, "<image><url>%S</url></image>\n", site.image);
     write(arena, "\n");
 
-    for (Each_Page(it, posts))
+    for (i64 i = 0; i < posts->count; i += 1)
     {
-        if (it->meta.draft) continue;
+        Page *it = page_view_get(posts, i);
 
         auto post_slug  = it->slug;
 
@@ -356,15 +917,8 @@ String generate_blog_rss_feed(Site_Meta site, Page *posts)
 
 String escape_html(String text)
 {
-    if (string_contains(text, S("<")) || string_contains(text, S(">")))
-    {
-        // NOTE(nick): crazy inefficient!
-        // :StringReplaceHack
-        auto parts = string_split(text, S("<"));
-        text = string_join(parts, S("&lt;"));
-        parts = string_split(text, S(">"));
-        text = string_join(parts, S("&gt;"));
-    }
+    text = string_replace(temp_arena(), text, S("<"), S("&lt;"), 0);
+    text = string_replace(temp_arena(), text, S(">"), S("&gt;"), 0);
     return text;
 }
 
@@ -389,7 +943,7 @@ void write_link(Arena *arena, String text, String href)
 
 void write_clike_code_block(Arena *arena, String code)
 {
-    string_trim_newlines(&code);
+    code = string_trim_newlines(code);
     if (!code.count) return;
 
     auto tokens = c_tokenize(code);
@@ -399,25 +953,25 @@ void write_clike_code_block(Arena *arena, String code)
 
     For (tokens)
     {
-        auto whitespace = c_whitespace_before_token(&it, code);
+        auto whitespace = c_whitespace_before_token(it, code);
         arena_write(arena, whitespace);
 
         // NOTE(nick): we can ignore Identifier tokens because they have no special styling
-        if (it.type == C_TokenType_Identifier)
+        if (it->type == C_TokenType_Identifier)
         {
-            arena_write(arena, it.value);
+            arena_write(arena, it->value);
         }
         else if (
-            it.type == C_TokenType_Operator ||
-            it.type == C_TokenType_Semicolon ||
-            it.type == C_TokenType_Paren)
+            it->type == C_TokenType_Operator ||
+            it->type == C_TokenType_Semicolon ||
+            it->type == C_TokenType_Paren)
         {
-            arena_write(arena, escape_html(it.value));
+            arena_write(arena, escape_html(it->value));
         }
         else
         {
-            auto type = c_token_type_to_string(it.type);
-            auto tok = sprint("<span class='tok-%S'>%S</span>", type, it.value);
+            auto type = c_token_type_to_string(it->type);
+            auto tok = sprint("<span class='tok-%S'>%S</span>", type, it->value);
             arena_write(arena, tok);
         }
     }
@@ -427,39 +981,41 @@ void write_clike_code_block(Arena *arena, String code)
 
 void write_bash_code_block(Arena *arena, String code)
 {
-    string_trim_newlines(&code);
+    code = string_trim_newlines(code);
     if (!code.count) return;
 
     write(arena, "<pre class='code'>");
 
-    Array<String> lines = string_split(code, S("\n"));
+    auto lines = string_lines_begin(code);
+    String line = {};
 
-    for (i64 i = 0; i < lines.count; i += 1)
+    for (i64 i = 0; string_split_next(&lines, &line); i += 1)
     {
-        String line = lines[i];
+        if (i > 0) arena_write(arena, S("\n"));
 
-        i64 space_index = string_find(line, S(" "));
-        i64 terminal_index = string_find(line, S(">"));
+        i64 space_index = string_find(line, S(" "), 0, 0);
+        i64 terminal_index = string_find(line, S(">"), 0, 0);
         if (terminal_index < space_index)
         {
             arena_write(arena, string_slice(line, 0, terminal_index));
             string_advance(&line, terminal_index);
 
-            arena_print(arena, "<span class='tok-Keyword no_select'>></span>");
+            write(arena, "<span class='tok-Keyword no_select'>></span>");
             string_advance(&line, 1);
 
 
             while (line.count > 0 && char_is_whitespace(line.data[0]))
             {
-                arena_print(arena, "%c", line.data[0]);
+                write(arena, "%c", line.data[0]);
                 string_advance(&line, 1);
             }
         }
 
-        Array<String> parts = string_split(line, S(" "));
+        auto parts = string_split_begin(line, S(" "));
+        String it = {};
 
-        For_Index (parts) {
-            String it = parts[index];
+        for (i64 index = 0; string_split_next(&parts, &it); index += 1) {
+            if (index > 0) arena_write(arena, S(" "));
 
             if (index == 0) {
                 auto tok = sprint("<span class='tok-Function'>%S</span>", it);
@@ -467,7 +1023,7 @@ void write_bash_code_block(Arena *arena, String code)
             }
             else if (string_contains(it, S("-")))
             {
-                i64 equals_index = string_find(it, S("="), 0);
+                i64 equals_index = string_find(it, S("="), 0, 0);
                 if (equals_index < it.count)
                 {
                     String pre = string_slice(it, 0, equals_index);
@@ -476,7 +1032,7 @@ void write_bash_code_block(Arena *arena, String code)
                     auto tok = sprint("<span class='tok-Number'>%S</span>", pre);
                     arena_write(arena, tok);
 
-                    arena_print(arena, "<span class='tok-Keyword'>=</span>");
+                    write(arena, "<span class='tok-Keyword'>=</span>");
 
                     auto tok2 = sprint("<span class='tok-String'>%S</span>", post);
                     arena_write(arena, tok2);
@@ -491,10 +1047,7 @@ void write_bash_code_block(Arena *arena, String code)
             {
                 arena_write(arena, it);
             }
-            if (index < parts.count - 1) arena_write(arena, S(" "));
         }
-
-        if (i < lines.count - 1) arena_write(arena, S("\n"));
     }
 
     write(arena, "</pre>");
@@ -506,10 +1059,7 @@ void write_quote(Arena *arena, String quote)
 
     // @Incomplete: special handling for the citation line (last line starting with a "-")
 
-    // NOTE(nick): sort of inefficient
-    // :StringReplaceHack
-    auto parts = string_split(quote, S("--"));
-    quote = string_join(parts, S("—"));
+    quote = string_replace(temp_arena(), quote, S("--"), S("—"), 0);
 
     write(arena, "<blockquote class='quote'>%S</blockquote>", quote);
 }
@@ -533,20 +1083,21 @@ String find_yaml_frontmatter(String str) {
 
 String string_normalize_newlines(String input)
 {
-    String result = {};
+    static Char_Set carriage_return = char_set_make(S("\r"));
+
     u8 *data = PushArray(temp_arena(), u8, input.count);
     u8 *at = data;
 
-    for (i64 i = 0; i < input.count; i ++)
+    i64 i = 0;
+    while (i < input.count)
     {
-        char it = input.data[i];
-        if (it == '\r')
-        {
-            continue;
-        }
+        i64 next = string_find_char_set(input, &carriage_return, i);
+
+        MemoryCopy(at, input.data + i, next - i);
+        at += next - i;
 
-        *at = it;
-        at ++;
+        // NOTE(nick): skip the \r
+        i = next + 1;
     }
 
     return string_make(data, at - data);
@@ -555,16 +1106,12 @@ String string_normalize_newlines(String input)
 i64 string_count_words(String str)
 {
     i64 result = 0;
-    while (str.count > 0)
+    bool in_word = false;
+    for (i64 i = 0; i < str.count; i += 1)
     {
-        string_eat_whitespace(&str);
-        
-        result += 1;
-
-        while (str.count > 0 && !char_is_whitespace(str.data[0]))
-        {
-            string_advance(&str, 1);
-        }
+        bool is_space = char_is_whitespace(str.data[i]);
+        if (!is_space && !in_word) result += 1;
+        in_word = !is_space;
     }
     return result;
 }
@@ -572,10 +1119,8 @@ i64 string_count_words(String str)
 // NOTE(nick): in the future maybe we could let the sign of the argument
 // determine the order in which we output posts
 // e.g. @posts(-5) could be the last 5 posts
-void write_page_card_list(Arena *arena, Page *items, Page *last_item, i64 limit)
+void write_page_card_list(Arena *arena, Page_View *items, i64 limit)
 {
-    i64 count = 0;
-
     //~nja: blog list
     write(arena, "<div class='flex-y csy-16'>\n");
 
@@ -586,11 +1131,13 @@ void write_page_card_list(Arena *arena, Page *items, Page *last_item, i64 limit)
         reverse = true;
     }
 
+    i64 count = Min(limit, items->count);
+
     // NOTE(nick): iterate forwards or backwards
-    for (auto *it = (reverse ? last_item : items); it != NULL; (reverse ? it = it->prev : it = it->next))
+    for (i64 i = 0; i < count; i += 1)
     {
-        if (it->meta.draft) continue;
-        if (count++ >= limit) break;
+        Page *it = page_view_get(items, reverse ? items->count - 1 - i : i);
+        depend_on(sprint("meta:%S", it->slug));
 
         auto post_title = it->meta.title;
         auto post_slug  = it->slug;
@@ -621,13 +1168,22 @@ void write_page_card_list(Arena *arena, Page *items, Page *last_item, i64 limit)
     print("Done!\n");
 }
 
-void write_custom_tag(Arena *arena, String tag_name, Array<String> args)
+void write_custom_tag(Arena *arena, String tag_name, String args)
 {
-    String arg0 = args.count > 0 ? yaml_to_string(args[0]) : String{};
-    String arg1 = args.count > 1 ? yaml_to_string(args[1]) : String{};
+    // NOTE(nick): tags only ever look at their first two arguments
+    String arg0 = {};
+    String arg1 = {};
+
+    auto parts = string_split_begin(args, S(","));
+    String part = {};
+    if (string_split_next(&parts, &part)) arg0 = string_trim_whitespace(part);
+    if (string_split_next(&parts, &part)) arg1 = string_trim_whitespace(part);
+
+    if (arg0.count) arg0 = yaml_to_string(arg0);
+    if (arg1.count) arg1 = yaml_to_string(arg1);
 
     if (false) {}
-    else if (string_match(tag_name, S("link"), MatchFlags_IgnoreCase))
+    else if (string_match(tag_name, S("link"), MatchFlag_IgnoreCase))
     {
         auto text = arg0;
         auto href = arg1;
@@ -636,8 +1192,8 @@ void write_custom_tag(Arena *arena, String tag_name, Array<String> args)
 
         write_link(arena, text, href);
     }
-    else if (string_match(tag_name, S("img"), MatchFlags_IgnoreCase) ||
-             string_match(tag_name, S("image"), MatchFlags_IgnoreCase)
+    else if (string_match(tag_name, S("img"), MatchFlag_IgnoreCase) ||
+             string_match(tag_name, S("image"), MatchFlag_IgnoreCase)
         )
     {
         auto src = arg0;
@@ -646,52 +1202,58 @@ void write_custom_tag(Arena *arena, String tag_name, Array<String> args)
 
         write_image(arena, src, alt);
     }
-    else if (string_match(tag_name, S("code"), MatchFlags_IgnoreCase))
+    else if (string_match(tag_name, S("code"), MatchFlag_IgnoreCase))
     {
         auto str = arg0;
         write(arena, "<code class='inline_code'>%S</code>", str);
     }
-    else if (string_match(tag_name, S("quote"), MatchFlags_IgnoreCase))
+    else if (string_match(tag_name, S("quote"), MatchFlag_IgnoreCase))
     {
         auto str = arg0;
         write_quote(arena, str);
     }
-    else if (string_match(tag_name, S("iframe"), MatchFlags_IgnoreCase))
+    else if (string_match(tag_name, S("iframe"), MatchFlag_IgnoreCase))
     {
         auto src = arg0;
         write(arena, "<div class='video'><iframe src='%S' allowfullscreen='' frameborder='0'></iframe></div>", src);
     }
-    else if (string_match(tag_name, S("hr"), MatchFlags_IgnoreCase))
+    else if (string_match(tag_name, S("hr"), MatchFlag_IgnoreCase))
     {
         auto str = arg0;
         write(arena, "<hr/>", str);
     }
-    else if (string_match(tag_name, S("posts"), MatchFlags_IgnoreCase))
+    else if (string_match(tag_name, S("posts"), MatchFlag_IgnoreCase))
     {
         i64 limit = I64_MAX;
-        if (arg0.count > 0) limit = string_to_i64(arg0);
+        if (arg0.count > 0) limit = string_to_i64(arg0, 10);
 
-        write_page_card_list(arena, ctx.posts, ctx.last_post, limit);
+        depend_on(S("list:post"));
+        write_page_card_list(arena, &ctx.posts, limit);
     }
-    else if (string_match(tag_name, S("projects"), MatchFlags_IgnoreCase))
+    else if (string_match(tag_name, S("projects"), MatchFlag_IgnoreCase))
     {
         i64 limit = I64_MAX;
-        if (arg0.count > 0) limit = string_to_i64(arg0);
+        if (arg0.count > 0) limit = string_to_i64(arg0, 10);
 
-        write_page_card_list(arena, ctx.projects, ctx.last_project, limit);
+        depend_on(S("list:project"));
+        write_page_card_list(arena, &ctx.projects, limit);
     }
-    else if (string_match(tag_name, S("post_list"), MatchFlags_IgnoreCase))
+    else if (string_match(tag_name, S("post_list"), MatchFlag_IgnoreCase))
     {
         i64 limit = I64_MAX;
-        if (arg0.count > 0) limit = string_to_i64(arg0);
-        i64 count = 0;
+        if (arg0.count > 0) limit = string_to_i64(arg0, 10);
+
+        depend_on(S("list:post"));
+
+        // NOTE(nick): newest first
+        i64 count = Clamp(limit, 0, ctx.posts.count);
 
         //~nja: blog list
         write(arena, "<div class='flex-y csy-16'>\n");
-        for (Each_Node_Reverse(it, ctx.last_post))
+        for (i64 i = 0; i < count; i += 1)
         {
-            if (it->meta.draft) continue;
-            if (count++ >= limit) break;
+            Page *it = page_view_get(&ctx.posts, ctx.posts.count - 1 - i);
+            depend_on(sprint("meta:%S", it->slug));
 
             auto title = it->meta.title;
             auto post_slug  = it->slug;
@@ -716,12 +1278,14 @@ void write_custom_tag(Arena *arena, String tag_name, Array<String> args)
         }
         write(arena, "</div>\n");
     }
-    else if (string_match(tag_name, S("featured"), MatchFlags_IgnoreCase))
+    else if (string_match(tag_name, S("featured"), MatchFlag_IgnoreCase))
     {
         i64 limit = I64_MAX;
-        if (arg0.count > 0) limit = string_to_i64(arg0);
+        if (arg0.count > 0) limit = string_to_i64(arg0, 10);
         i64 count = 0;
 
+        depend_on(S("site:featured_links"));
+
         write(arena, "<div class='grid marb-32'>");
 
         for (Each_Node(it, ctx.site.featured))
@@ -753,49 +1317,430 @@ String make_html_id(String text, i32 header_level)
     String result = {};
     if (header_level <= 3)
     {
-        auto parts = string_split(text, S(" "));
-        result = string_lower(string_join(parts, S("_")));
+        result = string_lower(temp_arena(), string_replace(temp_arena(), text, S(" "), S("_"), 0));
     }
     return result;
 }
 
-// @Incomplete: supported nested tags
-// @Speed: arena_print is actually sort of slower than you might think (especially when doing for each character)
-String markdown_to_html(String text)
+//
+// Markdown
+//
+// Markdown is parsed in two passes. The block pass walks the lines and builds one flat array of
+// nodes: blocks plus their inline children, in pre-order, each with the size of its subtree.
+// The renderer walks that array and writes the html. Anything else that wants to look at the
+// structure of a page (headers, plain text) can walk the same array without re-scanning the source.
+//
+
+// NOTE(nick): returns the end of the plain text run that starts at start_index
+// A newline ends the run (inclusive) so the next line still gets its start-of-line checks.
+i64 markdown_find_special(String text, i64 start_index)
 {
-    Arena *arena = arena_alloc_from_memory(gigabytes(1));
+    // NOTE(nick): the start of some inline markup, an escape, or the end of a line
+    static Char_Set special_chars = char_set_make(S("\\<-h[@*_~`\n"));
 
-    text = string_normalize_newlines(text);
+    i64 i = start_index;
 
-    bool was_line_break = true;
-    i64 html_scope_depth = 0;
+    while (true)
+    {
+        i = string_find_char_set(text, &special_chars, i);
+        if (i >= text.count) break;
 
-    for (i64 i = 0; i < text.count; i += 1)
+        u8 c = text.data[i];
+        if (c == '\n') return i + 1;
+
+        // NOTE(nick): only http:// and https:// links care about an 'h'
+        if (c != 'h' || (i + 3 < text.count && text.data[i + 1] == 't' && text.data[i + 2] == 't' && text.data[i + 3] == 'p'))
+        {
+            break;
+        }
+
+        i += 1;
+    }
+
+    return i;
+}
+
+// NOTE(nick): returns the index of the closing character if it shows up before the end of the line
+// (text.count otherwise)
+i64 markdown_find_closing(String text, i64 start_index, Char_Set *closing)
+{
+    i64 i = string_find_char_set(text, closing, start_index);
+    if (i < text.count && text.data[i] == '\n')
     {
-        char it = text.data[i];
+        i = text.count;
+    }
+    return i;
+}
 
-        char prev_it = i > 0 ? text.data[i - 1] : '\0';
-        bool start_of_line = prev_it == '\n';
-        bool escaped = it == '\\';
+typedef u32 Markdown_Node_Type;
+enum {
+    MarkdownNode_None = 0,
+
+    // NOTE(nick): blocks
+    MarkdownNode_Paragraph,
+    MarkdownNode_Break,
+    MarkdownNode_Rule,
+    MarkdownNode_Header,
+    MarkdownNode_Code_Block,
+    MarkdownNode_Quote,
+    MarkdownNode_List,
+    MarkdownNode_Ordered_List,
+    MarkdownNode_List_Item,
+
+    // NOTE(nick): inline
+    MarkdownNode_Text,
+    MarkdownNode_Html,
+    MarkdownNode_Em_Dash,
+    MarkdownNode_Link,
+    MarkdownNode_Custom_Tag,
+    MarkdownNode_Bold,
+    MarkdownNode_Italic,
+    MarkdownNode_Strike,
+    MarkdownNode_Code,
+
+    MarkdownNode_COUNT,
+};
+
+struct Markdown_Node
+{
+    Markdown_Node_Type type;
+    i32 level;       // header level
+
+    String text;     // text, link text, tag name, code
+    String arg;      // link href, tag args, code block language
+
+    i64 descendants; // number of nodes in the subtree (not including this one)
+};
+
+struct Markdown_Doc
+{
+    Markdown_Node *nodes;
+    i64 count;
+
+    i64 words; // NOTE(nick): in the text the nodes show, so markdown syntax and html tags aren't counted
+};
+
+struct Markdown_Parser
+{
+    // NOTE(nick): in the temp arena, when it fills up the nodes are copied into a block twice the size
+    Markdown_Node *nodes;
+    i64 count;
+    i64 capacity;
+
+    i64 paragraph_index;
+    i64 html_scope_depth;
+};
+
+i64 markdown_push_node(Markdown_Parser *p, Markdown_Node_Type type, String text = {}, String arg = {})
+{
+    Markdown_Node node = {};
+    node.type = type;
+    node.text = text;
+    node.arg  = arg;
+
+    if (p->count == p->capacity)
+    {
+        i64 capacity = Max(p->capacity * 2, 256);
+        Markdown_Node *nodes = PushArray(temp_arena(), Markdown_Node, capacity);
+        if (p->count) MemoryCopy(nodes, p->nodes, sizeof(Markdown_Node) * p->count);
+
+        p->nodes    = nodes;
+        p->capacity = capacity;
+    }
+
+    p->nodes[p->count] = node;
+    p->count += 1;
+    return p->count - 1;
+}
+
+void markdown_end_node(Markdown_Parser *p, i64 index)
+{
+    p->nodes[index].descendants = p->count - index - 1;
+}
+
+void markdown_end_paragraph(Markdown_Parser *p)
+{
+    if (p->paragraph_index >= 0)
+    {
+        markdown_end_node(p, p->paragraph_index);
+        p->paragraph_index = -1;
+    }
+}
+
+i64 markdown_push_block(Markdown_Parser *p, Markdown_Node_Type type, String text = {}, String arg = {})
+{
+    markdown_end_paragraph(p);
+    return markdown_push_node(p, type, text, arg);
+}
+
+void markdown_push_text(Markdown_Parser *p, String text)
+{
+    // NOTE(nick): merge runs that are next to each other in the source
+    if (p->count > 0)
+    {
+        Markdown_Node *last = &p->nodes[p->count - 1];
+        if (last->type == MarkdownNode_Text && last->text.data + last->text.count == text.data)
+        {
+            last->text.count += text.count;
+            return;
+        }
+    }
+
+    markdown_push_node(p, MarkdownNode_Text, text);
+}
+
+void markdown_parse_inline_range(Markdown_Parser *p, String text);
+
+// NOTE(nick): parses the inline element that starts at index i and returns the index of the last character it used
+i64 markdown_parse_inline(Markdown_Parser *p, String text, i64 i)
+{
+    char it = text.data[i];
+
+    if (it == '\\')
+    {
+        i += 1;
+        if (i < text.count)
+        {
+            markdown_push_text(p, string_slice(text, i, i + 1));
+        }
+        return i;
+    }
+
+    // html tags and comments
+    if (it == '<' && i < text.count - 1)
+    {
+        char next = text.data[i + 1];
+        // html tag
+        if (char_is_alpha(next) || next == '/')
+        {
+            i64 start_index = i;
+            i += 2; // <a
+            while (i < text.count && text.data[i] != '>') i += 1;
+
+            markdown_push_node(p, MarkdownNode_Html, string_slice(text, start_index, i + 1));
+
+            if (next == '/') {
+                p->html_scope_depth -= 1;
+            } else {
+                p->html_scope_depth += 1;
+            }
+
+            return i;
+        }
+
+        // html comment
+        if (next == '!' && i < text.count - 3 && text.data[i + 2] == '-' && text.data[i + 3] == '-')
+        {
+            i64 start_index = i;
+            i += 4; // <!--
+
+            while (i < text.count)
+            {
+                // -->
+                if (
+                    i < text.count - 3 &&
+                    (text.data[i] == '-' && text.data[i + 1] == '-' && text.data[i + 2] == '>'))
+                {
+                    i += 2;
+                    break;
+                }
+
+                i += 1;
+            }
+
+            markdown_push_node(p, MarkdownNode_Html, string_slice(text, start_index, i + 3));
+            return i;
+        }
+    }
 
-        if (escaped)
+    // em dash
+    if (it == '-')
+    {
+        // NOTE(nick): markdown actually uses 2 and 3 dashes to be en and em dashes respectively
+        // but we don't really care about that for now...
+        if (i < text.count - 1 && text.data[i + 1] == '-')
         {
             i += 1;
-            if (i < text.count)
+            markdown_push_node(p, MarkdownNode_Em_Dash);
+            return i;
+        }
+    }
+
+    // inline links
+    if (it == 'h')
+    {
+        // http:// or https://
+        if (i < text.count - 8)
+        {
+            if (text.data[i + 1] == 't' && text.data[i + 2] == 't' && text.data[i + 3] == 'p')
             {
-                arena_print(arena, "%c", text.data[i]);
+                auto slice = string_slice(text, i, text.count);
+                if (
+                    string_starts_with(slice, S("https://")) ||
+                    string_starts_with(slice, S("http://"))
+                )
+                {
+                    i64 start_index = i;
+
+                    while (i < text.count && !char_is_whitespace(text.data[i]))
+                    {
+                        i += 1;
+                    }
+
+                    auto link_href = string_slice(text, start_index, i);
+                    markdown_push_node(p, MarkdownNode_Link, link_href, link_href);
+                    return i;
+                }
             }
-            continue;
         }
+    }
+
+    // links
+    if (it == '[')
+    {
+        i += 1;
+        i64 text_start = i;
+        while (i < text.count && text.data[i] != ']' && text.data[i] != '\n') i += 1;
+
+        i += 1;
+
+        if (text.data[i - 1] == ']' && text.data[i] == '(')
+        {
+            i64 text_end = i - 1;
+            i += 1;
+            auto link_text = string_slice(text, text_start, text_end);
+
+            i64 link_start = i;
+            while (i < text.count && text.data[i] != ')' && text.data[i] != '\n') i += 1;
+            if (text.data[i] == ')')
+            {
+                auto link_href = string_slice(text, link_start, i);
+
+                markdown_push_node(p, MarkdownNode_Link, link_text, link_href);
+                return i;
+            }
+            else
+            {
+                i = text_start - 1;
+            }
+        }
+        else
+        {
+            i = text_start - 1;
+        }
+    }
+
+    // custom expressions
+    if (it == '@')
+    {
+        i += 1;
+        i64 tag_start = i;
+
+        while (i < text.count && (char_is_alpha(text.data[i]) || text.data[i] == '_'))
+        {
+            i += 1;
+        }
+
+        i64 tag_end = i;
+
+        char bracket = text.data[i];
+        if (bracket == '(' || bracket == '[' || bracket == '{')
+        {
+            char closing_bracket = bracket == '(' ? ')' : (bracket == '[' ? ']' : '}');
+
+            i += 1;
+            while (i < text.count && text.data[i] != closing_bracket) i += 1;
+
+            auto tag_name = string_slice(text, tag_start, tag_end);
+            auto arg_str  = string_slice(text, tag_end + 1, i);
+
+            markdown_push_node(p, MarkdownNode_Custom_Tag, tag_name, arg_str);
+            return i;
+        }
+        else
+        {
+            i = tag_start - 1;
+        }
+    }
+
+    // NOTE(nick): closing character + end of line for each of the inline styles
+    static Char_Set bold_chars   = char_set_make(S("*\n"));
+    static Char_Set italic_chars = char_set_make(S("_\n"));
+    static Char_Set strike_chars = char_set_make(S("~\n"));
+    static Char_Set code_chars   = char_set_make(S("`\n"));
+
+    Markdown_Node_Type style = MarkdownNode_None;
+    Char_Set *closing = NULL;
+
+    switch (it)
+    {
+        case '*': { style = MarkdownNode_Bold;   closing = &bold_chars;   } break;
+        case '_': { style = MarkdownNode_Italic; closing = &italic_chars; } break;
+        case '~': { style = MarkdownNode_Strike; closing = &strike_chars; } break;
+        case '`': { style = MarkdownNode_Code;   closing = &code_chars;   } break;
+    }
+
+    if (closing)
+    {
+        i64 closing_index = markdown_find_closing(text, i + 1, closing);
+        if (closing_index < text.count)
+        {
+            auto inner = string_slice(text, i + 1, closing_index);
+
+            if (style == MarkdownNode_Code)
+            {
+                markdown_push_node(p, style, inner);
+            }
+            else
+            {
+                i64 index = markdown_push_node(p, style);
+                markdown_parse_inline_range(p, inner);
+                markdown_end_node(p, index);
+            }
+
+            return closing_index;
+        }
+    }
+
+    // plain text
+    // NOTE(nick): nothing else can happen until the next special character (or the end of the line),
+    // so copy the whole run at once instead of going through the loop for every character
+    i64 run_end = it == '\n' ? i + 1 : markdown_find_special(text, i + 1);
+    markdown_push_text(p, string_slice(text, i, run_end));
+    return run_end - 1;
+}
+
+void markdown_parse_inline_range(Markdown_Parser *p, String text)
+{
+    for (i64 i = 0; i < text.count; i += 1)
+    {
+        i = markdown_parse_inline(p, text, i);
+    }
+}
+
+Markdown_Doc markdown_parse(String text)
+{
+    Markdown_Parser parser = {};
+    Markdown_Parser *p = &parser;
+    p->paragraph_index = -1;
 
-        if (start_of_line)
+    bool was_line_break = true;
+
+    for (i64 i = 0; i < text.count; i += 1)
+    {
+        char it = text.data[i];
+
+        char prev_it = i > 0 ? text.data[i - 1] : '\0';
+        bool start_of_line = prev_it == '\n';
+
+        if (start_of_line && it != '\\')
         {
             // line breaks (cheap <p> trick)
             if (it == '\n')
             {
-                if (!was_line_break && html_scope_depth <= 0)
+                if (!was_line_break && p->html_scope_depth <= 0)
                 {
-                    arena_print(arena, "<p></p>");
+                    markdown_push_block(p, MarkdownNode_Break);
                     was_line_break = true;
                 }
                 continue;
@@ -809,7 +1754,7 @@ String markdown_to_html(String text)
                 i += 2;
                 while (i < text.count && text.data[i] == '-') i += 1;
 
-                arena_print(arena, "<hr/>");
+                markdown_push_block(p, MarkdownNode_Rule);
                 continue;
             }
 
@@ -851,31 +1796,11 @@ String markdown_to_html(String text)
                 auto str = string_slice(text, code_start, code_end);
                 if (is_code_block)
                 {
-                    if (
-                        string_match(tag, S("c"), MatchFlags_IgnoreCase) ||
-                        string_match(tag, S("h"), MatchFlags_IgnoreCase) ||
-                        string_match(tag, S("cpp"), MatchFlags_IgnoreCase) ||
-                        string_match(tag, S("js"), MatchFlags_IgnoreCase) ||
-                        string_match(tag, S("javascript"), MatchFlags_IgnoreCase)
-                    )
-                    {
-                        write_clike_code_block(arena, str);
-                    }
-                    else if (
-                        string_match(tag, S("bash"), MatchFlags_IgnoreCase) ||
-                        string_match(tag, S("sh"), MatchFlags_IgnoreCase)
-                    )
-                    {
-                        write_bash_code_block(arena, str);
-                    }
-                    else
-                    {
-                        arena_print(arena, "<pre class='code'>%S</pre>", str);
-                    }
+                    markdown_push_block(p, MarkdownNode_Code_Block, str, tag);
                 }
                 else
                 {
-                    write_quote(arena, str);
+                    markdown_push_block(p, MarkdownNode_Quote, str);
                 }
 
                 continue;
@@ -899,8 +1824,8 @@ String markdown_to_html(String text)
                     while (text.data[i] != '\n') i += 1;
 
                     auto header_text = string_slice(text, start_index, i);
-                    auto js_id = make_html_id(header_text, count);
-                    arena_print(arena, "<h%d id='%S'>%S</h%d>", count, js_id, header_text, count);
+                    i64 index = markdown_push_block(p, MarkdownNode_Header, header_text);
+                    p->nodes[index].level = (i32)count;
 
                     continue;
                 }
@@ -912,7 +1837,7 @@ String markdown_to_html(String text)
                 // bullet list
                 if (it == '-' && char_is_whitespace(text.data[i + 1]))
                 {
-                    arena_print(arena, "<ul>");
+                    i64 index = markdown_push_block(p, MarkdownNode_List);
 
                     while (i < text.count && text.data[i] == '-' && char_is_whitespace(text.data[i + 1]))
                     {
@@ -920,20 +1845,20 @@ String markdown_to_html(String text)
                         while (i < text.count && text.data[i] != '\n') i += 1;
 
                         auto item_text = string_slice(text, start, i);
-                        arena_print(arena, "<li>%S</li>", item_text);
+                        markdown_push_node(p, MarkdownNode_List_Item, item_text);
 
                         i += 1;
                     }
 
-                    arena_print(arena, "</ul>");
-                    arena_print(arena, "<p></p>");
+                    markdown_end_node(p, index);
+                    markdown_push_block(p, MarkdownNode_Break);
                     continue;
                 }
 
                 // number list
                 if (char_is_digit(it) && text.data[i + 1] == '.' && char_is_whitespace(text.data[i + 2]))
                 {
-                    arena_print(arena, "<ol>");
+                    i64 index = markdown_push_block(p, MarkdownNode_Ordered_List);
 
                     while (i < text.count)
                     {
@@ -946,20 +1871,20 @@ String markdown_to_html(String text)
                         while (i < text.count && text.data[i] != '\n') i += 1;
 
                         auto item_text = string_slice(text, start, i);
-                        arena_print(arena, "<li>%S</li>", item_text);
+                        markdown_push_node(p, MarkdownNode_List_Item, item_text);
 
                         i += 1;
                     }
 
-                    arena_print(arena, "</ol>");
-                    arena_print(arena, "<p></p>");
+                    markdown_end_node(p, index);
+                    markdown_push_block(p, MarkdownNode_Break);
                     continue;
                 }
 
                 // markdown-style quotes
                 if (it == '>' && char_is_whitespace(text.data[i + 1]))
                 {
-                    Array<String> lines = {};
+                    String_List lines = {};
 
                     while (i < text.count && text.data[i] == '>' && char_is_whitespace(text.data[i + 1]))
                     {
@@ -967,683 +1892,2960 @@ String markdown_to_html(String text)
                         while (i < text.count && text.data[i] != '\n') i += 1;
 
                         auto item_text = string_slice(text, start, i);
-                        array_push(&lines, item_text);
+                        string_list_push(temp_arena(), &lines, item_text);
 
                         i += 1;
                     }
 
-                    write_quote(arena, string_join(lines, S("\n")));
+                    markdown_push_block(p, MarkdownNode_Quote, string_list_join(temp_arena(), lines, S("\n")));
                     continue;
                 }
             }
         }
 
-        // html tags and comments
-        if (it == '<' && i < text.count - 1)
+        if (p->paragraph_index < 0)
         {
-            char next = text.data[i + 1];
-            // html tag
-            if (char_is_alpha(next) || next == '/')
-            {
-                i64 start_index = i;
-                i += 2; // <a
-                while (i < text.count && text.data[i] != '>') i += 1;
+            p->paragraph_index = markdown_push_node(p, MarkdownNode_Paragraph);
+        }
 
-                arena_print(arena, "%S", string_slice(text, start_index, i + 1));
+        i = markdown_parse_inline(p, text, i);
+    }
 
-                if (next == '/') {
-                    html_scope_depth -= 1;
-                } else {
-                    html_scope_depth += 1;
-                }
+    markdown_end_paragraph(p);
 
-                continue;
-            }
+    Markdown_Doc result = {};
+    result.nodes = p->nodes;
+    result.count = p->count;
 
-            // html comment
-            if (next == '!' && i < text.count - 3 && text.data[i + 2] == '-' && text.data[i + 3] == '-')
+    for (i64 index = 0; index < p->count; index += 1)
+    {
+        Markdown_Node *it = &p->nodes[index];
+        switch (it->type)
+        {
+            case MarkdownNode_Header:
+            case MarkdownNode_Code_Block:
+            case MarkdownNode_Quote:
+            case MarkdownNode_List_Item:
+            case MarkdownNode_Text:
+            case MarkdownNode_Link:
+            case MarkdownNode_Code:
             {
-                i64 start_index = i;
-                i += 4; // <!--
+                result.words += string_count_words(it->text);
+            } break;
+        }
+    }
 
-                while (i < text.count)
-                {
-                    // -->
-                    if (
-                        i < text.count - 3 &&
-                        (text.data[i] == '-' && text.data[i + 1] == '-' && text.data[i + 2] == '>'))
-                    {
-                        i += 2;
-                        break;
-                    }
+    return result;
+}
 
-                    i += 1;
-                }
+void markdown_render_children(Arena *arena, Markdown_Doc *doc, i64 index);
 
-                arena_print(arena, "%S", string_slice(text, start_index, i + 3));
-                continue;
-            }
-        }
+void markdown_render_node(Arena *arena, Markdown_Doc *doc, i64 index)
+{
+    Markdown_Node *it = &doc->nodes[index];
 
-        // em dash
-        if (it == '-')
+    switch (it->type)
+    {
+        case MarkdownNode_Paragraph:
         {
-            // NOTE(nick): markdown actually uses 2 and 3 dashes to be en and em dashes respectively
-            // but we don't really care about that for now...
-            if (i < text.count - 1 && text.data[i + 1] == '-')
-            {
-                i += 1;
-                arena_print(arena, "—");
-                continue;
-            }
-        }
+            markdown_render_children(arena, doc, index);
+        } break;
 
-        // inline links
-        if (it == 'h')
+        case MarkdownNode_Break:
         {
-            // http:// or https://
-            if (i < text.count - 8)
-            {
-                if (text.data[i + 1] == 't' && text.data[i + 2] == 't' && text.data[i + 3] == 'p')
-                {
-                    auto slice = string_slice(text, i, text.count);
-                    if (
-                        string_starts_with(slice, S("https://")) ||
-                        string_starts_with(slice, S("http://"))
-                    )
-                    {
-                        i64 start_index = i;
-
-                        while (i < text.count && !char_is_whitespace(text.data[i]))
-                        {
-                            i += 1;
-                        }
-
-                        auto link_href = string_slice(text, start_index, i);
-                        write_link(arena, link_href, link_href);
-                        continue;
-                    }
-                }
-            }
-        }
+            arena_write(arena, S("<p></p>"));
+        } break;
 
-        // links
-        if (it == '[')
+        case MarkdownNode_Rule:
         {
-            i += 1;
-            i64 text_start = i;
-            while (i < text.count && text.data[i] != ']' && text.data[i] != '\n') i += 1;
+            arena_write(arena, S("<hr/>"));
+        } break;
 
-            i += 1;
+        case MarkdownNode_Header:
+        {
+            auto js_id = make_html_id(it->text, it->level);
+            write(arena, "<h%d id='%S'>%S</h%d>", it->level, js_id, it->text, it->level);
+        } break;
 
-            if (text.data[i - 1] == ']' && text.data[i] == '(')
+        case MarkdownNode_Code_Block:
+        {
+            auto tag = it->arg;
+            auto str = it->text;
+
+            if (
+                string_match(tag, S("c"), MatchFlag_IgnoreCase) ||
+                string_match(tag, S("h"), MatchFlag_IgnoreCase) ||
+                string_match(tag, S("cpp"), MatchFlag_IgnoreCase) ||
+                string_match(tag, S("js"), MatchFlag_IgnoreCase) ||
+                string_match(tag, S("javascript"), MatchFlag_IgnoreCase)
+            )
             {
-                i64 text_end = i - 1;
-                i += 1;
-                auto link_text = string_slice(text, text_start, text_end);
-
-                i64 link_start = i;
-                while (i < text.count && text.data[i] != ')' && text.data[i] != '\n') i += 1;
-                if (text.data[i] == ')')
-                {
-                    auto link_href = string_slice(text, link_start, i);
-
-                    write_link(arena, link_text, link_href);
-                    continue;
-                }
-                else
-                {
-                    i = text_start - 1;
-                }
+                write_clike_code_block(arena, str);
+            }
+            else if (
+                string_match(tag, S("bash"), MatchFlag_IgnoreCase) ||
+                string_match(tag, S("sh"), MatchFlag_IgnoreCase)
+            )
+            {
+                write_bash_code_block(arena, str);
             }
             else
             {
-                i = text_start - 1;
+                write(arena, "<pre class='code'>%S</pre>", str);
             }
-        }
+        } break;
 
+        case MarkdownNode_Quote:
+        {
+            write_quote(arena, it->text);
+        } break;
 
-        // custom expressions
-        if (it == '@')
+        case MarkdownNode_List:
         {
-            i += 1;
-            i64 tag_start = i;
+            arena_write(arena, S("<ul>"));
+            markdown_render_children(arena, doc, index);
+            arena_write(arena, S("</ul>"));
+        } break;
 
-            while (i < text.count && (char_is_alpha(text.data[i]) || text.data[i] == '_'))
-            {
-                i += 1;
-            }
+        case MarkdownNode_Ordered_List:
+        {
+            arena_write(arena, S("<ol>"));
+            markdown_render_children(arena, doc, index);
+            arena_write(arena, S("</ol>"));
+        } break;
 
-            i64 tag_end = i;
+        case MarkdownNode_List_Item:
+        {
+            write(arena, "<li>%S</li>", it->text);
+        } break;
 
-            char bracket = text.data[i];
-            if (bracket == '(' || bracket == '[' || bracket == '{')
-            {
-                char closing_bracket = bracket == '(' ? ')' : (bracket == '[' ? ']' : '}');
+        case MarkdownNode_Text:
+        case MarkdownNode_Html:
+        {
+            arena_write(arena, it->text);
+        } break;
 
-                i += 1;
-                while (i < text.count && text.data[i] != closing_bracket) i += 1;
+        case MarkdownNode_Em_Dash:
+        {
+            arena_write(arena, S("—"));
+        } break;
 
-                auto tag_name = string_slice(text, tag_start, tag_end);
-                auto arg_str  = string_slice(text, tag_end + 1, i);
+        case MarkdownNode_Link:
+        {
+            write_link(arena, it->text, it->arg);
+        } break;
 
-                auto args = string_split(arg_str, S(","));
-                For_Index(args) {
-                    args[index] = string_trim_whitespace(args[index]);
-                }
+        case MarkdownNode_Custom_Tag:
+        {
+            write_custom_tag(arena, it->text, it->arg);
+        } break;
 
-                write_custom_tag(arena, tag_name, args);
-                continue;
-            }
-            else
-            {
-                i = tag_start - 1;
-            }
+        case MarkdownNode_Bold:
+        {
+            arena_write(arena, S("<b>"));
+            markdown_render_children(arena, doc, index);
+            arena_write(arena, S("</b>"));
+        } break;
+
+        case MarkdownNode_Italic:
+        {
+            arena_write(arena, S("<i>"));
+            markdown_render_children(arena, doc, index);
+            arena_write(arena, S("</i>"));
+        } break;
+
+        case MarkdownNode_Strike:
+        {
+            arena_write(arena, S("<s>"));
+            markdown_render_children(arena, doc, index);
+            arena_write(arena, S("</s>"));
+        } break;
+
+        case MarkdownNode_Code:
+        {
+            write(arena, "<code class='inline_code'>%S</code>", it->text);
+        } break;
+    }
+}
+
+void markdown_render_children(Arena *arena, Markdown_Doc *doc, i64 index)
+{
+    i64 end = index + doc->nodes[index].descendants + 1;
+    for (i64 i = index + 1; i < end; i += doc->nodes[i].descendants + 1)
+    {
+        markdown_render_node(arena, doc, i);
+    }
+}
+
+// NOTE(nick): arena should be empty, the html is everything that gets written to it
+String markdown_render(Arena *arena, Markdown_Doc *doc)
+{
+    for (i64 i = 0; i < doc->count; i += doc->nodes[i].descendants + 1)
+    {
+        markdown_render_node(arena, doc, i);
+    }
+
+    String result = arena_to_string(arena);
+
+    if (string_ends_with(result, S("<p></p>")))
+    {
+        result.count -= S("<p></p>").count;
+    }
+
+    return result;
+}
+
+String markdown_to_html(Arena *arena, String text, i64 *words = NULL)
+{
+    text = string_normalize_newlines(text);
+
+    auto doc = markdown_parse(text);
+    if (words) *words = doc.words;
+
+    return markdown_render(arena, &doc);
+}
+
+
+//
+// Render Arenas
+//
+// Scratch memory for rendering one page: the html of the whole page, the content part of it (for
+// critical css) and the markdown html before it's copied into the markdown cache. A page takes a
+// set from the pool when it starts and puts it back when it's written, so there are only ever as
+// many sets as pages being rendered at once (the job count), no matter how big the site is.
+//
+// Resetting an arena decommits everything past ARENA_DECOMMIT_THRESHOLD, so what stays resident
+// between pages is small. The most any page needed is kept so the build can report it.
+//
+
+#define RENDER_ARENA_SIZE Megabytes(256) // NOTE(nick): only reserved, pages are nowhere near this
+#define RENDER_ARENA_MAX_SETS 64
+
+struct Render_Arenas
+{
+    Arena *page;
+    Arena *content;
+    Arena *markdown;
+
+    Render_Arenas *next;
+};
+
+struct Render_Arena_Pool
+{
+    Render_Arenas *free;
+    i64 count;           // every set that was ever made
+    u64 high_water_mark; // the most any one arena needed for a page
+
+    Mutex mutex;
+};
+
+static Render_Arena_Pool render_arena_pool = {};
+
+// NOTE(nick): the set the current thread is rendering a page into
+thread_local Render_Arenas *render_arenas = NULL;
+
+// NOTE(nick): must be called on the main thread before any pages are rendered
+void render_arena_pool_init()
+{
+    if (!render_arena_pool.mutex.handle) render_arena_pool.mutex = mutex_create(0);
+}
+
+Render_Arenas *render_arenas_acquire()
+{
+    Render_Arena_Pool *pool = &render_arena_pool;
+
+    mutex_aquire_lock(&pool->mutex);
+
+    Render_Arenas *result = pool->free;
+    if (result)
+    {
+        pool->free = result->next;
+    }
+    else
+    {
+        assert(pool->count < RENDER_ARENA_MAX_SETS);
+        pool->count += 1;
+
+        result = New(Render_Arenas, 1);
+        result->page     = arena_alloc(RENDER_ARENA_SIZE);
+        result->content  = arena_alloc(RENDER_ARENA_SIZE);
+        result->markdown = arena_alloc(RENDER_ARENA_SIZE);
+    }
+
+    mutex_release_lock(&pool->mutex);
+
+    result->next = NULL;
+    return result;
+}
+
+void render_arenas_release(Render_Arenas *arenas)
+{
+    Render_Arena_Pool *pool = &render_arena_pool;
+
+    u64 used = Max(arenas->page->pos, Max(arenas->content->pos, arenas->markdown->pos));
+
+    arena_reset(arenas->page);
+    arena_reset(arenas->content);
+    arena_reset(arenas->markdown);
+
+    mutex_aquire_lock(&pool->mutex);
+
+    pool->high_water_mark = Max(pool->high_water_mark, used);
+
+    arenas->next = pool->free;
+    pool->free = arenas;
+
+    mutex_release_lock(&pool->mutex);
+}
+
+//
+// Markdown Cache
+//
+// The html of a page body only depends on its markdown source and whatever the custom tags in it
+// read (e.g. @posts reads the list of posts). Bodies are kept with those deps, in memory and in a
+// cache file next to the output dir, so a page whose shell changed doesn't re-parse its markdown.
+//
+
+Markdown_Cache_Entry *markdown_cache_find(Markdown_Cache *cache, u64 hash)
+{
+    if (!cache->index.slots) return NULL;
+
+    Markdown_Cache_Entry **result = (Markdown_Cache_Entry **)table_get(&cache->index, table_hash_make(hash), &hash);
+    return result ? *result : NULL;
+}
+
+Markdown_Cache_Entry *markdown_cache_push(Markdown_Cache *cache, Markdown_Cache_Entry *entry)
+{
+    if (!cache->index.slots) table_init(&cache->index, sizeof(u64), sizeof(Markdown_Cache_Entry *));
+
+    entry->next = NULL;
+    QueuePush(cache->first, cache->last, entry);
+    cache->count += 1;
+
+    table_set(&cache->index, table_hash_make(entry->hash), &entry->hash, &entry);
+    return entry;
+}
+
+bool markdown_cache_entry_is_current(Markdown_Cache_Entry *entry)
+{
+    for (Each_Node(node, entry->deps))
+    {
+        auto dep = dependency_find(node->dep->key);
+        if (!dep || dep->hash != node->hash) return false;
+    }
+    return true;
+}
+
+// NOTE(nick): the entries read from the cache file stay around for the whole run
+void free_markdown_cache_entry(Markdown_Cache_Entry **entry)
+{
+    if (*entry && (*entry)->owned)
+    {
+        free_dependency_list(&(*entry)->deps);
+        os_free(*entry);
+    }
+    *entry = NULL;
+}
+
+Markdown_Cache_Entry *render_page_body(Page *it)
+{
+    u64 hash = content_hash(it->content);
+
+    // NOTE(nick): in watch mode the page still has its body from the last build
+    Markdown_Cache_Entry *entry = it->body;
+    if (!entry || entry->hash != hash || !markdown_cache_entry_is_current(entry))
+    {
+        entry = markdown_cache_find(&ctx.prev_markdown_cache, hash);
+        if (entry && !markdown_cache_entry_is_current(entry)) entry = NULL;
+    }
+
+    if (entry)
+    {
+        for (Each_Node(node, entry->deps))
+        {
+            depend_on(node->dep->key);
         }
+    }
+    else
+    {
+        capturing_deps = true;
+        captured_deps  = NULL;
+        i64 words = 0;
+        auto html = markdown_to_html(render_arenas->markdown, it->content, &words);
+        capturing_deps = false;
+
+        // NOTE(nick): the html goes right after the entry
+        entry = (Markdown_Cache_Entry *)os_alloc(sizeof(Markdown_Cache_Entry) + html.count);
+        entry->hash  = hash;
+        entry->html  = string_make((u8 *)(entry + 1), html.count);
+        entry->words = words;
+        entry->deps  = copy_dependency_list(captured_deps);
+        entry->owned = true;
+        MemoryCopy(entry->html.data, html.data, html.count);
+    }
+
+    if (it->body != entry) free_markdown_cache_entry(&it->body);
+
+    it->body = entry;
+    return entry;
+}
+
+
+//
+// Critical CSS
+//
+// style.css is almost all utility classes, and a page only uses a few of them. With --critical-css
+// the minified css is split into rules once per build, and every page only inlines the rules
+// whose selectors can match the classes that show up in its html (or that the scripts toggle).
+//
+// Rules that don't need a class (element selectors, :root, @font-face, ...) are always kept, and
+// anything inside parens is ignored, so a:not(.no-hover) counts as a rule for every a.
+//
 
+// NOTE(nick): only the names, not what they match, a.foo and .foo .bar both just need foo (and bar)
+u64 *css_push_selector_classes(Arena *arena, String selectors, i64 *count)
+{
+    // NOTE(nick): every class takes at least 2 chars, plus a 0 after every selector
+    u64 *result = PushArray(arena, u64, selectors.count + 1);
+    u8 *name = PushArray(temp_arena(), u8, selectors.count);
+
+    i64 paren_depth = 0;
+    i64 i = 0;
+    while (i < selectors.count)
+    {
+        u8 c = selectors.data[i];
+
+        if (c == '(') paren_depth += 1;
+        if (c == ')') paren_depth -= 1;
 
-        // bold
-        if (it == '*')
+        if (c == '[' || c == '"' || c == '\'')
+        {
+            u8 close = c == '[' ? ']' : c;
+            i += 1;
+            while (i < selectors.count && selectors.data[i] != close) i += 1;
+        }
+        else if (c == ',' && paren_depth == 0)
+        {
+            result[*count] = 0;
+            *count += 1;
+        }
+        else if (c == '.' && paren_depth == 0)
         {
-            i64 newline_index = string_find(text, S("\n"), i + 1);
-            i64 closing_index = string_find(text, S("*"), i + 1);
-            if (newline_index > closing_index && closing_index < text.count)
+            i64 name_count = 0;
+            i += 1;
+            while (i < selectors.count)
             {
-                arena_print(arena, "<b>%S</b>", string_slice(text, i + 1, closing_index));
-                i = closing_index;
-                continue;
+                u8 ch = selectors.data[i];
+                if (ch == '\\' && i + 1 < selectors.count)
+                {
+                    name[name_count] = selectors.data[i + 1];
+                    name_count += 1;
+                    i += 2;
+                }
+                else if (char_is_alpha(ch) || char_is_digit(ch) || ch == '-' || ch == '_' || ch >= 0x80)
+                {
+                    name[name_count] = ch;
+                    name_count += 1;
+                    i += 1;
+                }
+                else
+                {
+                    break;
+                }
             }
+
+            result[*count] = content_hash(string_make(name, name_count));
+            *count += 1;
+            continue;
         }
 
-        // italic
-        if (it == '_')
+        i += 1;
+    }
+
+    result[*count] = 0;
+    *count += 1;
+
+    return result;
+}
+
+// NOTE(nick): returns the index of the } that closes the block opened at open_index
+i64 css_find_block_end(String css, i64 open_index)
+{
+    i64 depth = 0;
+    for (i64 i = open_index; i < css.count; i += 1)
+    {
+        u8 c = css.data[i];
+        if (c == '"' || c == '\'')
         {
-            i64 newline_index = string_find(text, S("\n"), i + 1);
-            i64 closing_index = string_find(text, S("_"), i + 1);
-            if (newline_index > closing_index && closing_index < text.count)
-            {
-                arena_print(arena, "<i>%S</i>", string_slice(text, i + 1, closing_index));
-                i = closing_index;
-                continue;
-            }
+            i += 1;
+            while (i < css.count && css.data[i] != c) i += 1;
         }
-        
-        // strike
-        if (it == '~')
+        else if (c == '{')
         {
-            i64 newline_index = string_find(text, S("\n"), i + 1);
-            i64 closing_index = string_find(text, S("~"), i + 1);
-            if (newline_index > closing_index && closing_index < text.count)
-            {
-                arena_print(arena, "<s>%S</s>", string_slice(text, i + 1, closing_index));
-                i = closing_index;
-                continue;
-            }
+            depth += 1;
+        }
+        else if (c == '}')
+        {
+            depth -= 1;
+            if (depth == 0) return i;
         }
+    }
+    return css.count - 1;
+}
+
+void build_css_index()
+{
+    Css_Index *index = &ctx.css_index;
+
+    if (!index->arena) index->arena = arena_alloc(Megabytes(16));
+    arena_reset(index->arena);
+
+    index->rules = NULL;
+    index->count = 0;
+
+    String css = ctx.css;
+
+    // NOTE(nick): there can't be more rules than closing braces
+    i64 capacity = 1;
+    for (i64 i = 0; i < css.count; i += 1)
+    {
+        if (css.data[i] == '}' || css.data[i] == ';') capacity += 1;
+    }
+    index->rules = PushArrayZero(index->arena, Css_Rule, capacity);
+
+    M_Temp temp = arena_begin_temp(temp_arena());
+
+    String media = {};
 
-        // inline code
-        if (it == '`')
+    i64 i = 0;
+    while (i < css.count)
+    {
+        u8 c = css.data[i];
+        if (char_is_whitespace(c)) { i += 1; continue; }
+
+        // NOTE(nick): the end of the @media block we were in
+        if (c == '}')
         {
-            i64 newline_index = string_find(text, S("\n"), i + 1);
-            i64 closing_index = string_find(text, S("`"), i + 1);
-            if (newline_index > closing_index && closing_index < text.count)
-            {
-                arena_print(arena, "<code class='inline_code'>%S</code>", string_slice(text, i + 1, closing_index));
-                i = closing_index;
-                continue;
-            }
+            media = {};
+            i += 1;
+            continue;
+        }
+
+        i64 open = string_find(css, S("{"), i, 0);
+        i64 semicolon = string_find(css, S(";"), i, 0);
+
+        Css_Rule *rule = &index->rules[index->count];
+
+        // NOTE(nick): @import and @charset
+        if (semicolon < open)
+        {
+            rule->text   = string_slice(css, i, semicolon + 1);
+            rule->media  = media;
+            rule->always = true;
+            index->count += 1;
+
+            i = semicolon + 1;
+            continue;
+        }
+
+        if (open >= css.count) break;
+
+        String prelude = string_slice(css, i, open);
+
+        if (!media.count && (string_starts_with(prelude, S("@media")) || string_starts_with(prelude, S("@supports"))))
+        {
+            media = prelude;
+            i = open + 1;
+            continue;
         }
 
-        // output character
-        u8 *output = PushStruct(arena, u8);
-        *output = it;
+        i64 close = css_find_block_end(css, open);
+
+        rule->text  = string_slice(css, i, close + 1);
+        rule->media = media;
+
+        if (prelude.count && prelude.data[0] == '@')
+        {
+            rule->always = true;
+        }
+        else
+        {
+            rule->classes = css_push_selector_classes(index->arena, prelude, &rule->class_count);
+        }
+
+        index->count += 1;
+        i = close + 1;
     }
 
-    String result = arena_to_string(arena);
+    arena_end_temp(temp);
+}
 
-    if (string_ends_with(result, S("<p></p>")))
+// NOTE(nick): class names are split on whitespace, the hash of each one is added to the set
+void add_class_names(Table_KV *set, String names)
+{
+    i64 i = 0;
+    while (i < names.count)
     {
-        result.count -= S("<p></p>").count;
+        while (i < names.count && char_is_whitespace(names.data[i])) i += 1;
+
+        i64 start = i;
+        while (i < names.count && !char_is_whitespace(names.data[i])) i += 1;
+
+        if (i > start)
+        {
+            u64 hash = content_hash(string_slice(names, start, i));
+            bool used = true;
+            table_set(set, table_hash_make(hash), &hash, &used);
+        }
     }
+}
 
-    return result;
+void add_classes_from_html(Table_KV *set, String html)
+{
+    i64 i = 0;
+    for (;;)
+    {
+        i = string_find(html, S("class="), i, 0);
+        if (i + S("class=").count >= html.count) break;
+
+        i += S("class=").count;
+
+        u8 quote = html.data[i];
+        if (quote != '\'' && quote != '"') continue;
+
+        i64 end = string_find(html, string_make(&quote, 1), i + 1, 0);
+        add_class_names(set, string_slice(html, i + 1, end));
+        i = end;
+    }
 }
 
+// NOTE(nick): class names can't be found in scripts, so every word in a string literal counts (e.g. classList.toggle('invert'))
+void add_classes_from_js(Table_KV *set, String js)
+{
+    i64 i = 0;
+    while (i < js.count)
+    {
+        u8 quote = js.data[i];
+        i += 1;
 
-static String global_public_path = {};
+        if (quote != '\'' && quote != '"' && quote != '`') continue;
 
-HTTP_REQUEST_CALLBACK(request_callback)
+        i64 start = i;
+        while (i < js.count && js.data[i] != quote)
+        {
+            if (js.data[i] == '\\') i += 1;
+            i += 1;
+        }
+
+        add_class_names(set, string_slice(js, start, Min(i, js.count)));
+        i += 1;
+    }
+}
+
+bool css_class_is_used(Table_KV *page_classes, u64 hash)
+{
+    return table_get(&ctx.shell.classes, table_hash_make(hash), &hash) ||
+           table_get(page_classes, table_hash_make(hash), &hash);
+}
+
+// NOTE(nick): a rule is used if any one of its selectors has all of its classes on the page
+bool css_rule_is_used(Css_Rule *rule, Table_KV *page_classes)
+{
+    if (rule->always) return true;
+
+    bool all_used = true;
+    for (i64 i = 0; i < rule->class_count; i += 1)
+    {
+        u64 hash = rule->classes[i];
+        if (hash == 0)
+        {
+            if (all_used) return true;
+            all_used = true;
+        }
+        else if (all_used && !css_class_is_used(page_classes, hash))
+        {
+            all_used = false;
+        }
+    }
+
+    return false;
+}
+
+void write_critical_css(Arena *arena, Table_KV *page_classes)
+{
+    Css_Index *index = &ctx.css_index;
+
+    arena_write(arena, S("<style type='text/css'>"));
+
+    String media = {};
+    for (i64 i = 0; i < index->count; i += 1)
+    {
+        Css_Rule *rule = &index->rules[i];
+        if (!css_rule_is_used(rule, page_classes)) continue;
+
+        if (!string_equals(rule->media, media))
+        {
+            if (media.count) arena_write(arena, S("}"));
+            if (rule->media.count)
+            {
+                arena_write(arena, rule->media);
+                arena_write(arena, S("{"));
+            }
+            media = rule->media;
+        }
+
+        arena_write(arena, rule->text);
+    }
+
+    if (media.count) arena_write(arena, S("}"));
+
+    arena_write(arena, S("</style>\n"));
+}
+
+// NOTE(nick): the dev server sends a "change" event with the url of every page it rebuilds (or * for everything)
+static String live_reload_js = S(
+    "new EventSource('/_live_reload').addEventListener('change',function(e){"
+        "var path=location.pathname.replace(/(\\.html|\\/)$/,'')||'/index';"
+        "if(e.data==='*'||e.data===path)location.reload();"
+    "});"
+);
+
+//
+// Page Shell
+//
+// Everything on a page besides its meta tags and its content (the head, the inlined css and js,
+// the header nav, the footer) is the same for every page in a build. compile_page_shell writes
+// it out once into static segments with slots between them, and render_page just copies the
+// segments and fills in the slots, so none of the shell goes through the formatter per page.
+//
+
+void page_shell_slot(Page_Shell *shell, Page_Slot slot)
+{
+    assert(shell->count < PAGE_SHELL_MAX_SEGMENTS);
+
+    String written = arena_to_string(shell->arena);
+
+    Page_Shell_Segment *segment = &shell->segments[shell->count];
+    segment->text = string_slice(written, shell->mark, written.count);
+    segment->slot = slot;
+
+    shell->count += 1;
+    shell->mark = written.count;
+}
+
+void page_shell_depend_on(Page_Shell *shell, String key)
+{
+    string_list_push(shell->deps_arena, &shell->deps, PushStringCopy(shell->deps_arena, key));
+}
+
+// NOTE(nick): must be called (on the main thread) after build_dependency_table and before any pages are rendered
+void compile_page_shell()
+{
+    Page_Shell *shell = &ctx.shell;
+
+    if (!shell->arena)      shell->arena      = arena_alloc(Megabytes(64));
+    if (!shell->deps_arena) shell->deps_arena = arena_alloc(Megabytes(1));
+    arena_reset(shell->arena);
+    arena_reset(shell->deps_arena);
+
+    Arena *arena = shell->arena;
+    shell->count = 0;
+    shell->mark  = 0;
+    shell->deps  = {};
+
+    auto site = ctx.site;
+
+    page_shell_depend_on(shell, S("site:name"));
+    page_shell_depend_on(shell, S("site:url"));
+    page_shell_depend_on(shell, S("site:twitter_handle"));
+    page_shell_depend_on(shell, S("site:theme_color"));
+    page_shell_depend_on(shell, S("site:social_icons"));
+    page_shell_depend_on(shell, S("file:style.css"));
+    page_shell_depend_on(shell, S("file:script.js"));
+    page_shell_depend_on(shell, S("build:live_reload"));
+    page_shell_depend_on(shell, S("build:assets"));
+
+    //~nja: html template
+
+    write(arena, "<!DOCTYPE html>\n");
+    write(arena, "<html lang='en'>\n");
+
+    write(arena, "<head>\n");
+    write(arena, "<meta charset='utf-8' />\n");
+    write(arena, "<meta name='viewport' content='width=device-width, initial-scale=1' />\n");
+
+    write(arena, "<title>");                                   page_shell_slot(shell, PageSlot_Title);
+    write(arena, "</title>\n");
+    write(arena, "<meta name='description' content='");        page_shell_slot(shell, PageSlot_Description);
+    write(arena, "' />\n");
+
+    write(arena, "<meta itemprop='name' content='");           page_shell_slot(shell, PageSlot_Title);
+    write(arena, "'>\n");
+    write(arena, "<meta itemprop='description' content='");    page_shell_slot(shell, PageSlot_Description);
+    write(arena, "'>\n");
+    write(arena, "<meta itemprop='image' content='");          page_shell_slot(shell, PageSlot_Image);
+    write(arena, "'>\n");
+
+    write(arena, "<meta property='og:title' content='");       page_shell_slot(shell, PageSlot_Title);
+    write(arena, "' />\n");
+    write(arena, "<meta property='og:description' content='"); page_shell_slot(shell, PageSlot_Description);
+    write(arena, "' />\n");
+    write(arena, "<meta property='og:type' content='");        page_shell_slot(shell, PageSlot_Og_Type);
+    write(arena, "' />\n");
+    write(arena, "<meta property='og:url' content='");         page_shell_slot(shell, PageSlot_Url);
+    write(arena, "' />\n");
+    write(arena, "<meta property='og:site_name' content='%S' />\n", site.name);
+    write(arena, "<meta property='og:locale' content='en_us' />\n");
+
+    write(arena, "<meta name='twitter:card' content='summary' />\n");
+    write(arena, "<meta name='twitter:title' content='");       page_shell_slot(shell, PageSlot_Title);
+    write(arena, "' />\n");
+    write(arena, "<meta name='twitter:description' content='"); page_shell_slot(shell, PageSlot_Description);
+    write(arena, "' />\n");
+    write(arena, "<meta name='twitter:image' content='");       page_shell_slot(shell, PageSlot_Image);
+    write(arena, "' />\n");
+    write(arena, "<meta name='twitter:site' content='%S' />\n", site.twitter_handle);
+
+    //write(arena, "<link rel='icon' type='image/png' href='%S' sizes='%dx%d' />\n", asset_path, size, size);
+
+    if (site.theme_color.count)
+    {
+    write(arena, "<meta name='theme-color' content='%S' />\n", site.theme_color);
+    write(arena, "<meta name='msapplication-TileColor' content='%S' />\n", site.theme_color);
+    }
+
+    write(arena, "<link rel='shortcut icon' href='/favicon.png' sizes='32x32' />\n");
+
+    if (ctx.css_file.count)
+    {
+    write(arena, "<link rel='stylesheet' type='text/css' href='/%S' />\n", ctx.css_file);
+    }
+    else if (ctx.css.count && !ctx.critical_css)
+    {
+    write(arena, "<style type='text/css'>%S</style>\n", ctx.css);
+    }
+
+    if (ctx.rss_feed.count)
+    {
+    write(arena, "<link rel='alternate' type='application/rss+xml' title='Nick Aversano' href='%S/feed.xml' />\n", site.url);
+    }
+
+    write(arena, "</head>\n");
+    //~nja: body
+    write(arena, "<body class='"); page_shell_slot(shell, PageSlot_Title);
+    write(arena, "'>\n");
+
+    // NOTE(nick): lightning.js swaps the body of the page on navigation and keeps the head, so the
+    // rules for a page have to come along with its body
+    if (ctx.critical_css && ctx.css.count)
+    {
+    page_shell_slot(shell, PageSlot_Styles);
+    }
+
+    //~nja: header
+    write(arena, "<div class='content flex-x pad-64  xs:flex-y sm:csy-8 sm:pad-32'>\n");
+        write(arena, "<div class='csx-16 flex-1 flex-x center-y'>\n");
+            write(arena, "<span class='font-24 font-bold'><a href='%S'>%S</a></span>\n", S("/"), site.name);
+        write(arena, "</div>\n");
+
+        write(arena, "<div class='csx-16 flex-x'>\n");
+
+        for (Each_Link(it, ctx.site.social_icons))
+        {
+            auto name  = it->title;
+            auto image = it->desc;
+            auto url   = it->href;
+
+            auto content = include_file(image)->content;
+            page_shell_depend_on(shell, sprint("file:%S", image));
+
+            write(arena, "<a title='%S' href='%S' target='_blank' class='inline-flex center pad-8'><div class='inline-block size-20'>%S</div></a>\n", name, url, content);
+        }
+        write(arena, "</div>\n");
+    write(arena, "</div>\n");
+
+    page_shell_slot(shell, PageSlot_Content);
+
+    //~nja: footer
+    write(arena, "<div class='content pad-64 w-800 sm:pad-32 flex-y center-x'>\n");
+
+    write(arena, "<a class='pad-16' onclick='toggle()'>💡</a>\n");
+
+    write(arena, "<div style='min-width: 64px; max-width: 64px; margin-bottom: -64px'>\n");
+    write_image(arena, S("guy_pixel.png"), S("Guy"));
+    write(arena, "</div>\n");
+
+    write(arena, "</div>\n");
+
+    if (ctx.js_file.count)
+    {
+    write(arena, "<script src='/%S'></script>\n", ctx.js_file);
+    }
+    else
+    {
+    write(arena, "<script>%S</script>\n", ctx.js);
+    }
+    write(arena, "<script src='/lightning.js'></script>\n");
+
+    if (ctx.live_reload)
+    {
+    write(arena, "<script>%S</script>\n", live_reload_js);
+    }
+
+    write(arena, "</body>\n");
+
+    write(arena, "</html>\n");
+
+    page_shell_slot(shell, PageSlot_None);
+
+    if (ctx.critical_css)
+    {
+        if (!shell->classes.slots) table_init(&shell->classes, sizeof(u64), sizeof(bool));
+        table_reset(&shell->classes);
+
+        for (i64 index = 0; index < shell->count; index += 1)
+        {
+            add_classes_from_html(&shell->classes, shell->segments[index].text);
+        }
+        add_classes_from_js(&shell->classes, ctx.js);
+    }
+}
+
+void write_page_content(Arena *arena, Page *it)
+{
+    auto page = it->meta;
+    auto body = render_page_body(it);
+
+    //~nja: image header / banner
+    if (page.image.count)
+    {
+    write(arena, "<div class='hero w-full bg-light'>\n");
+        write_image(arena, page.image, S(""), S("class='cover'"));
+    write(arena, "</div>\n");
+    }
+
+    // @Incomplete: we can actually make this work for other types of things too!
+    //~nja: post / project next / prev links
+    if (string_equals(it->type, S("post")) || string_equals(it->type, S("project")))
+    {
+        depend_on(sprint("nav:%S", it->slug));
+
+        auto links = find_next_and_prev_pages(it);
+        write(arena, "<div class='content padx-64 sm:padx-32 h-64 flex-x center-y csx-32' style='margin-bottom: -2rem'>");
+            if (links.prev)
+            {
+                write(arena, "<a class='font-bold pady-16' href='%S'>← Prev</a>", post_link(links.prev));
+            }
+            if (links.next)
+            {
+                write(arena, "<a class='font-bold pady-16 align-right' href='%S'>Next →</a>", post_link(links.next));
+            }
+        write(arena, "</div>\n");
+    }
+
+    //~nja: page content
+    write(arena, "<div id='content' class='content pad-64 sm:pad-32'>\n");
+
+        //~nja: page header
+        if (page.title.count || page.date.count)
+        {
+        write(arena, "<div class='marb-32'>\n", page.title);
+            if (string_contains(it->slug, S("posts/")))
+            {
+                i64 words = body->words;
+                i64 avg_read_time_mins = (i64)((words / 300.0f) + 0.5f);
+                if (avg_read_time_mins > 0)
+                {
+                    write(arena, "<div class='c-gray' style='font-size:0.8rem'>%d min read</div>\n", avg_read_time_mins);
+                }
+                else
+                {
+                    write(arena, "<div class='c-gray' style='font-size:0.8rem'>&lt;1 min read</div>\n", avg_read_time_mins);
+                }
+            }
+            if (page.title.count)
+            {
+                write(arena, "<h1>%S</h1>\n", page.title);
+            }
+            if (page.date.count)
+            {
+                write(arena, "<div class='c-gray'>%S</div>\n", pretty_date(ParsePostDate(page.date)));
+            }
+            if (page.author.count)
+            {
+                depend_on(S("site:author_links"));
+                Link *author = find_link_by_title(page.author, &ctx.authors_by_title);
+                if (author)
+                {
+                    write(arena, "<div>By <a class='font-bold link' href='%S'>%S</a></div>\n",
+                        author->href, author->title);
+                }
+                else
+                {
+                    write(arena, "<div>By <span class='font-bold'>%S</span></div>\n", page.author);
+                }
+            }
+        write(arena, "</div>\n", page.title);
+        }
+
+        arena_write(arena, body->html);
+
+    write(arena, "</div>\n");
+}
+
+thread_local Table_KV page_classes = {};
+
+String render_page(Arena *arena, Page *it)
+{
+    auto site = ctx.site;
+    auto shell = &ctx.shell;
+
+    auto page = it->meta;
+    auto meta = it->meta;
+
+    if (!meta.title.count)       meta.title = site.name;
+    if (!meta.description.count) meta.description = site.description;
+    if (!meta.image.count)       meta.image = site.image;
+    if (!meta.og_type.count)     meta.og_type = site.og_type;
+
+    for (String_Node *node = shell->deps.first; node; node = node->next)
+    {
+        depend_on(node->string);
+    }
+
+    if (!page.description.count) depend_on(S("site:description"));
+    if (!page.image.count)       depend_on(S("site:image"));
+    if (!page.og_type.count)     depend_on(S("site:og_type"));
+
+    // NOTE(nick): the styles come before the content, so we need to know which classes it uses first
+    String content = {};
+    if (ctx.critical_css)
+    {
+        write_page_content(render_arenas->content, it);
+        content = arena_to_string(render_arenas->content);
+
+        if (!page_classes.slots) table_init(&page_classes, sizeof(u64), sizeof(bool));
+        table_reset(&page_classes);
+
+        add_class_names(&page_classes, meta.title);
+        add_classes_from_html(&page_classes, content);
+    }
+
+    for (i64 index = 0; index < shell->count; index += 1)
+    {
+        Page_Shell_Segment *segment = &shell->segments[index];
+        arena_write(arena, segment->text);
+
+        switch (segment->slot)
+        {
+            case PageSlot_Title:       arena_write(arena, meta.title);       break;
+            case PageSlot_Description: arena_write(arena, meta.description); break;
+            case PageSlot_Image:       arena_write(arena, meta.image);       break;
+            case PageSlot_Og_Type:     arena_write(arena, meta.og_type);     break;
+            case PageSlot_Url:         arena_write(arena, meta.url);         break;
+            case PageSlot_Styles:      write_critical_css(arena, &page_classes); break;
+
+            case PageSlot_Content:
+            {
+                if (ctx.critical_css) arena_write(arena, content);
+                else                  write_page_content(arena, it);
+            } break;
+        }
+    }
+
+    return arena_to_string(arena);
+}
+
+//
+// Build Manifest
+//
+
+// NOTE(nick): any change to the generator itself can change the output for the same inputs,
+// so every new build of the binary starts from a clean manifest
+static String generator_version = S("myspace 1 " __DATE__ " " __TIME__);
+
+Manifest_Entry *manifest_find(Build_Manifest *manifest, String input)
+{
+    if (!manifest->index.slots) return NULL;
+
+    u64 key = content_hash(input);
+    Manifest_Entry **result = (Manifest_Entry **)table_get(&manifest->index, table_hash_make(key), &key);
+
+    if (result && string_equals((*result)->input, input))
+    {
+        return *result;
+    }
+
+    return NULL;
+}
+
+Manifest_Entry *manifest_push(Build_Manifest *manifest, String input, u64 hash, u64 size = 0, Dense_Time updated_at = 0)
+{
+    if (!manifest->index.slots) table_init(&manifest->index, sizeof(u64), sizeof(Manifest_Entry *));
+    if (!manifest->arenas[0])
+    {
+        manifest->arenas[0] = arena_alloc(Megabytes(64));
+        manifest->arenas[1] = arena_alloc(Megabytes(64));
+    }
+
+    Manifest_Entry *entry = PushStructZero(manifest->arenas[0], Manifest_Entry);
+    entry->input      = PushStringCopy(manifest->arenas[0], input);
+    entry->hash       = hash;
+    entry->size       = size;
+    entry->updated_at = updated_at;
+
+    DLLPushBack(manifest->first, manifest->last, entry);
+    manifest->count += 1;
+
+    u64 key = content_hash(input);
+    table_set(&manifest->index, table_hash_make(key), &key, &entry);
+
+    return entry;
+}
+
+// NOTE(nick): in watch mode the same input gets written again after every change
+Manifest_Entry *manifest_put(Build_Manifest *manifest, String input, u64 hash, u64 size = 0, Dense_Time updated_at = 0)
+{
+    Manifest_Entry *entry = manifest_find(manifest, input);
+    if (!entry) return manifest_push(manifest, input, hash, size, updated_at);
+
+    entry->hash       = hash;
+    entry->size       = size;
+    entry->updated_at = updated_at;
+    return entry;
+}
+
+// NOTE(nick): almost every input has exactly one output
+void manifest_set_output(Build_Manifest *manifest, Manifest_Entry *entry, String output)
+{
+    if (entry->outputs.first && string_equals(entry->outputs.first->string, output)) return;
+
+    entry->outputs = {};
+    string_list_push(manifest->arenas[0], &entry->outputs, PushStringCopy(manifest->arenas[0], output));
+}
+
+void manifest_remove(Build_Manifest *manifest, Manifest_Entry *entry)
+{
+    u64 key = content_hash(entry->input);
+    table_remove(&manifest->index, table_hash_make(key), &key);
+
+    DLLRemove(manifest->first, manifest->last, entry);
+    manifest->count -= 1;
+}
+
+// NOTE(nick): deletes what an input wrote to the output dir (and the .gz next to it), then forgets about the input
+void remove_outputs(Build_Manifest *manifest, Manifest_Entry *entry)
+{
+    for (String_Node *node = entry->outputs.first; node != NULL; node = node->next)
+    {
+        os_delete_file(path_join(ctx.output_dir, node->string));
+        os_delete_file(path_join(ctx.output_dir, sprint("%S.gz", node->string)));
+
+        auto gzip = manifest_find(manifest, sprint("gzip:%S", node->string));
+        if (gzip) manifest_remove(manifest, gzip);
+    }
+
+    manifest_remove(manifest, entry);
+}
+
+// NOTE(nick): in watch mode inputs get removed and outputs get renamed, so after every build the
+// entries that are left are copied over to the other arena and the old one is reset
+void manifest_compact(Build_Manifest *manifest)
+{
+    if (!manifest->arenas[0]) return;
+
+    Manifest_Entry *first = manifest->first;
+
+    Swap(Arena *, manifest->arenas[0], manifest->arenas[1]);
+    arena_reset(manifest->arenas[0]);
+
+    manifest->first = NULL;
+    manifest->last  = NULL;
+    manifest->count = 0;
+    table_reset(&manifest->index);
+
+    for (Each_Node(it, first))
+    {
+        auto entry = manifest_push(manifest, it->input, it->hash, it->size, it->updated_at);
+        for (String_Node *node = it->outputs.first; node != NULL; node = node->next)
+        {
+            string_list_push(manifest->arenas[0], &entry->outputs, PushStringCopy(manifest->arenas[0], node->string));
+        }
+        entry->deps = it->deps;
+    }
+}
+
+bool manifest_outputs_exist(Manifest_Entry *entry)
+{
+    for (String_Node *node = entry->outputs.first; node != NULL; node = node->next)
+    {
+        if (!os_file_exists(path_join(ctx.output_dir, node->string))) return false;
+    }
+    return true;
+}
+
+//
+// The manifest is a plain text file that lives next to the output directory:
+//
+//   <generator_version>
+//   file  <input>  <hash>  <size>  <updated_at>  <output>...
+//   dep   <key>    <hash>
+//
+// Fields are separated by tabs, hashes are hex. The dep lines belong to the file above them.
+//
+
+Build_Manifest read_build_manifest(String path)
+{
+    Build_Manifest result = {};
+
+    auto contents = os_read_entire_file(temp_arena(), path);
+    if (!contents.count) return result;
+
+    auto lines = string_lines_begin(contents);
+    String line = {};
+    if (!string_split_next(&lines, &line) || !string_equals(line, generator_version)) return result;
+
+    Manifest_Entry *entry = NULL;
+
+    while (string_split_next(&lines, &line))
+    {
+        auto parts = string_split_begin(line, S("\t"));
+
+        String kind = {};
+        string_split_next(&parts, &kind);
+
+        if (false) {}
+        else if (string_equals(kind, S("dep")) && entry)
+        {
+            String key  = {};
+            String hash = {};
+            if (!string_split_next(&parts, &key) || !string_split_next(&parts, &hash)) continue;
+
+            // NOTE(nick): these only carry the key, page_is_up_to_date looks up the real dependency
+            Dependency *dep = PushStructZero(temp_arena(), Dependency);
+            dep->key = key;
+
+            Dependency_Node *node = PushStructZero(temp_arena(), Dependency_Node);
+            node->dep  = dep;
+            node->hash = string_to_u64(hash, 16);
+            node->next = entry->deps;
+            entry->deps = node;
+        }
+        else if (string_equals(kind, S("file")))
+        {
+            // NOTE(nick): input, hash, size and updated_at, then the outputs
+            String fields[4] = {};
+            i64 field_count = 0;
+            while (field_count < count_of(fields) && string_split_next(&parts, &fields[field_count])) field_count += 1;
+            if (field_count < count_of(fields)) continue;
+
+            entry = manifest_push(&result, fields[0], string_to_u64(fields[1], 16), string_to_u64(fields[2], 10), string_to_u64(fields[3], 10));
+
+            String output = {};
+            while (string_split_next(&parts, &output))
+            {
+                string_list_push(result.arenas[0], &entry->outputs, PushStringCopy(result.arenas[0], output));
+            }
+        }
+    }
+
+    return result;
+}
+
+bool write_build_manifest(String path, Build_Manifest *manifest)
+{
+    Arena *arena = arena_alloc(Megabytes(32));
+
+    write(arena, "%S\n", generator_version);
+
+    for (Each_Node(it, manifest->first))
+    {
+        write(arena, "file\t%S\t%016llx\t%llu\t%llu", it->input, it->hash, it->size, it->updated_at);
+        for (String_Node *node = it->outputs.first; node != NULL; node = node->next)
+        {
+            write(arena, "\t%S", node->string);
+        }
+        write(arena, "\n");
+
+        for (Each_Node(node, it->deps))
+        {
+            write(arena, "dep\t%S\t%016llx\n", node->dep->key, node->hash);
+        }
+    }
+
+    bool result = os_write_entire_file(path, arena_to_string(arena));
+
+    arena_free(arena);
+    return result;
+}
+
+//
+// The markdown cache file is binary, because the html can contain anything:
+//
+//   <generator_version>\n
+//   then for each entry:
+//   u64 hash, u64 html_count, html, i64 words, u32 dep_count, then (u32 key_count, key, u64 hash) for each dep
+//
+
+bool cache_read(String *at, void *data, u64 size)
+{
+    if (at->count < size) return false;
+
+    MemoryCopy(data, at->data, size);
+    string_advance(at, size);
+    return true;
+}
+
+bool cache_read_string(String *at, u64 count, String *result)
+{
+    if (at->count < count) return false;
+
+    *result = string_slice(*at, 0, count);
+    string_advance(at, count);
+    return true;
+}
+
+void cache_write(Arena *arena, void *data, u64 size)
+{
+    arena_write(arena, string_make((u8 *)data, size));
+}
+
+Markdown_Cache read_markdown_cache(String path)
+{
+    Markdown_Cache result = {};
+
+    auto contents = os_read_entire_file(temp_arena(), path);
+    if (!contents.count) return result;
+
+    auto header = string_concat(generator_version, S("\n"));
+    if (!string_starts_with(contents, header)) return result;
+
+    String at = contents;
+    string_advance(&at, header.count);
+
+    while (at.count > 0)
+    {
+        Markdown_Cache_Entry *entry = PushStructZero(temp_arena(), Markdown_Cache_Entry);
+
+        u64 html_count = 0;
+        u32 dep_count = 0;
+        if (!cache_read(&at, &entry->hash, sizeof(u64))) break;
+        if (!cache_read(&at, &html_count, sizeof(u64))) break;
+        if (!cache_read_string(&at, html_count, &entry->html)) break;
+        if (!cache_read(&at, &entry->words, sizeof(i64))) break;
+        if (!cache_read(&at, &dep_count, sizeof(u32))) break;
+
+        bool ok = true;
+        for (u32 i = 0; i < dep_count && ok; i += 1)
+        {
+            // NOTE(nick): these only carry the key, markdown_cache_entry_is_current looks up the real dependency
+            Dependency *dep = PushStructZero(temp_arena(), Dependency);
+            Dependency_Node *node = PushStructZero(temp_arena(), Dependency_Node);
+
+            u32 key_count = 0;
+            ok = cache_read(&at, &key_count, sizeof(u32)) &&
+                cache_read_string(&at, key_count, &dep->key) &&
+                cache_read(&at, &node->hash, sizeof(u64));
+
+            node->dep  = dep;
+            node->next = entry->deps;
+            entry->deps = node;
+        }
+
+        if (!ok) break;
+
+        markdown_cache_push(&result, entry);
+    }
+
+    return result;
+}
+
+// NOTE(nick): exactly what write_markdown_cache writes for an entry
+u64 markdown_cache_entry_size(Markdown_Cache_Entry *entry)
+{
+    u64 result = sizeof(u64) + sizeof(u64) + entry->html.count + sizeof(i64) + sizeof(u32);
+    for (Each_Node(node, entry->deps))
+    {
+        result += sizeof(u32) + node->dep->key.count + sizeof(u64);
+    }
+    return result;
+}
+
+bool write_markdown_cache(String path)
+{
+    M_Temp temp = arena_begin_temp(temp_arena());
+
+    Markdown_Cache_Entry **entries = PushArray(temp_arena(), Markdown_Cache_Entry *, ctx.page_count);
+    i64 entry_count = 0;
+
+    Table_KV written = {};
+    table_init(&written, sizeof(u64), sizeof(bool));
+
+    u64 size = generator_version.count + 1;
+
+    for (Each_Page(it))
+    {
+        // NOTE(nick): pages that were up to date never looked at their body, but it is still good
+        Markdown_Cache_Entry *entry = it->body;
+        if (!entry) entry = markdown_cache_find(&ctx.prev_markdown_cache, content_hash(it->content));
+        if (!entry) continue;
+
+        H_Hash hash = table_hash_make(entry->hash);
+        if (table_get(&written, hash, &entry->hash)) continue;
+
+        bool did_write = true;
+        table_add(&written, hash, &entry->hash, &did_write);
+
+        entries[entry_count] = entry;
+        entry_count += 1;
+        size += markdown_cache_entry_size(entry);
+    }
+
+    table_free(&written);
+
+    // NOTE(nick): the arena header comes out of the reserved size too
+    Arena *arena = arena_alloc(AlignUpPow2(sizeof(Arena), 64) + size);
+
+    write(arena, "%S\n", generator_version);
+
+    for (i64 i = 0; i < entry_count; i += 1)
+    {
+        Markdown_Cache_Entry *entry = entries[i];
+
+        u64 html_count = entry->html.count;
+        cache_write(arena, &entry->hash, sizeof(u64));
+        cache_write(arena, &html_count, sizeof(u64));
+        arena_write(arena, entry->html);
+        cache_write(arena, &entry->words, sizeof(i64));
+
+        u32 dep_count = 0;
+        for (Each_Node(node, entry->deps)) dep_count += 1;
+        cache_write(arena, &dep_count, sizeof(u32));
+
+        for (Each_Node(node, entry->deps))
+        {
+            u32 key_count = (u32)node->dep->key.count;
+            cache_write(arena, &key_count, sizeof(u32));
+            arena_write(arena, node->dep->key);
+            cache_write(arena, &node->hash, sizeof(u64));
+        }
+    }
+
+    assert(arena->pos == size);
+    bool result = os_write_entire_file(path, arena_to_string(arena));
+
+    arena_free(arena);
+    arena_end_temp(temp);
+    return result;
+}
+
+bool page_is_up_to_date(Page *it)
+{
+    // NOTE(nick): in watch mode we still have everything from the last time this page was written
+    if (it->rendered)
+    {
+        if (it->rendered_hash != it->hash) return false;
+
+        for (Each_Node(node, it->deps))
+        {
+            if (node->dep->hash != node->hash) return false;
+        }
+        return true;
+    }
+
+    auto entry = manifest_find(&ctx.prev_manifest, it->path);
+    if (!entry || entry->hash != it->hash || !manifest_outputs_exist(entry)) return false;
+
+    Dependency_Node *deps = NULL;
+    for (Each_Node(node, entry->deps))
+    {
+        auto dep = dependency_find(node->dep->key);
+        if (!dep || dep->hash != node->hash) return false;
+
+        deps = push_dependency_node(deps, dep, node->hash);
+    }
+
+    // NOTE(nick): nothing this page read has changed, so it keeps the same dependencies
+    free_dependency_list(&it->deps);
+    it->deps          = copy_dependency_list(deps);
+    it->rendered      = true;
+    it->rendered_hash = it->hash;
+    return true;
+}
+
+void write_page(Page *it)
+{
+    reset_dependency_scratch();
+
+    M_Temp temp = arena_begin_temp(temp_arena());
+
+    it->up_to_date = page_is_up_to_date(it);
+    if (it->up_to_date)
+    {
+        arena_end_temp(temp);
+        return;
+    }
+
+    print("  %S\n", it->slug);
+
+    // NOTE(nick): every page renders into its own arenas and cleans up its own scratch memory,
+    // so pages can be generated in any order (or in parallel) and still produce the same bytes
+    render_arenas = render_arenas_acquire();
+
+    begin_recording_dependencies(it);
+    auto html = render_page(render_arenas->page, it);
+    end_recording_dependencies();
+    assert(replace_entire_file(path_join(ctx.output_dir, sprint("%S.html", it->slug)), html));
+
+    it->rendered      = true;
+    it->rendered_hash = it->hash;
+
+    arena_end_temp(temp);
+
+    render_arenas_release(render_arenas);
+    render_arenas = NULL;
+}
+
+struct Render_Pages_Job
+{
+    u64 page_count;
+    u64 volatile next_page_index;
+};
+
+WORKER_PROC(render_pages_worker)
+{
+    Render_Pages_Job *job = (Render_Pages_Job *)data;
+
+    for (;;)
+    {
+        u64 index = atomic_add_u64(&job->next_page_index, 1);
+        if (index >= job->page_count) break;
+
+        write_page(&ctx.pages[index]);
+    }
+}
+
+void write_all_pages(i64 job_count)
+{
+    render_arena_pool_init();
+
+    if (job_count <= 1)
+    {
+        for (Each_Page(it))
+        {
+            write_page(it);
+        }
+        return;
+    }
+
+    Render_Pages_Job job = {};
+    job.page_count = ctx.page_count;
+
+    // NOTE(nick): the main thread also pulls pages while it waits, so we only need N-1 workers
+    // The workers are started on the first build and every rebuild in watch mode reuses them.
+    static Work_Queue queue = {};
+    static bool queue_started = false;
+    if (!queue_started)
+    {
+        work_queue_init(&queue, job_count - 1);
+        queue_started = true;
+    }
+
+    for (i64 i = 0; i < job_count; i += 1)
+    {
+        work_queue_add_entry(&queue, render_pages_worker, &job);
+    }
+
+    work_queue_complete_all_work(&queue);
+}
+
+
+//
+// Data Files
+//
+
+void load_site_meta()
+{
+    // NOTE(nick): the values in ctx.site point into the file, so it is kept in the site arena too
+    if (!ctx.site_arena) ctx.site_arena = arena_alloc(Megabytes(16));
+    arena_reset(ctx.site_arena);
+
+    auto yaml = PushStringCopy(ctx.site_arena, os_read_entire_file(temp_arena(), path_join(ctx.data_dir, S("site.yaml"))));
+    ctx.site = parse_site_info(ctx.site_arena, yaml);
+
+    lookup_reset(&ctx.authors_by_title);
+    for (Each_Link(it, ctx.site.authors)) lookup_add(&ctx.authors_by_title, it->title, it);
+}
+
+void load_styles()
+{
+    // NOTE(nick): in watch mode these get loaded again after every change, so the old ones are freed
+    auto css = os_read_entire_file(temp_arena(), path_join(ctx.data_dir, S("style.css")));
+    string_free(&ctx.css);
+    ctx.css = string_alloc(minify_css(css));
+}
+
+void load_scripts()
+{
+    auto js = os_read_entire_file(temp_arena(), path_join(ctx.data_dir, S("script.js")));
+    string_free(&ctx.js);
+    ctx.js = string_alloc(minify_js(js));
+}
+
+// NOTE(nick): an inlined asset is sent again with every page, a separate file costs one more request
+// on the first visit. Anything that fits in the first round trip is cheaper inlined, unless there are
+// so many pages that the copies add up.
+static u64 asset_inline_max_size  = Kilobytes(14);
+static u64 asset_inline_max_total = Megabytes(1);
+
+bool asset_should_be_inlined(String content, i64 page_count)
+{
+    if (ctx.asset_mode == AssetMode_Inline)   return true;
+    if (ctx.asset_mode == AssetMode_External) return false;
+
+    return content.count <= asset_inline_max_size && content.count * page_count <= asset_inline_max_total;
+}
+
+// NOTE(nick): returns the name of the file pages should link to, or an empty string if they should inline it
+String write_asset_file(String stem, String ext, String content, bool inlined)
+{
+    auto input = string_concat(stem, ext);
+    u64 hash = content_hash(content);
+
+    // NOTE(nick): the name changes with the contents, so the server can tell browsers to cache it forever
+    String name = {};
+    if (!inlined)
+    {
+        name = sprint("%S.%016llx%S", stem, hash, ext);
+    }
+
+    // NOTE(nick): in watch mode the last build is in ctx.manifest, otherwise it's in prev_manifest
+    Build_Manifest *prev_manifest = &ctx.manifest;
+    auto prev = manifest_find(prev_manifest, input);
+    if (!prev)
+    {
+        prev_manifest = &ctx.prev_manifest;
+        prev = manifest_find(prev_manifest, input);
+    }
+
+    // NOTE(nick): when the name changes the old file goes, along with its .gz and gzip: entry
+    if (prev)
+    {
+        bool renamed = false;
+        for (String_Node *node = prev->outputs.first; node != NULL; node = node->next)
+        {
+            if (!string_equals(node->string, name)) renamed = true;
+        }
+
+        if (renamed) remove_outputs(prev_manifest, prev);
+    }
+
+    auto entry = manifest_put(&ctx.manifest, input, hash);
+    entry->outputs = {};
+
+    if (name.count)
+    {
+        manifest_set_output(&ctx.manifest, entry, name);
+
+        auto path = path_join(ctx.output_dir, name);
+        if (!os_file_exists(path)) replace_entire_file(path, content);
+    }
+
+    return name;
+}
+
+// NOTE(nick): must be called after the pages are loaded, the choice depends on how many there are
+void write_asset_files()
+{
+    i64 page_count = ctx.page_count;
+
+    // NOTE(nick): critical css is always inlined, each page gets its own part of it
+    bool inline_css = ctx.critical_css || asset_should_be_inlined(ctx.css, page_count);
+    bool inline_js  = asset_should_be_inlined(ctx.js, page_count);
+
+    ctx.css_file = write_asset_file(S("style"),  S(".css"), ctx.css, inline_css);
+    ctx.js_file  = write_asset_file(S("script"), S(".js"),  ctx.js,  inline_js);
+
+    if (ctx.critical_css) build_css_index();
+}
+
+void copy_public_file(String name, u64 size, Dense_Time updated_at)
+{
+    auto input = path_join(S("public"), name);
+    auto from_path = path_join(ctx.data_dir, input);
+    auto to_path = path_join(ctx.output_dir, name);
+
+    // NOTE(nick): in watch mode the last copy is in ctx.manifest, otherwise it's in prev_manifest
+    auto prev = manifest_find(&ctx.manifest, input);
+    if (!prev) prev = manifest_find(&ctx.prev_manifest, input);
+
+    // NOTE(nick): if the size and modified time match we trust the previous hash without reading the file
+    if (prev && prev->size == size && prev->updated_at == updated_at && manifest_outputs_exist(prev))
+    {
+        auto entry = manifest_put(&ctx.manifest, input, prev->hash, size, updated_at);
+        manifest_set_output(&ctx.manifest, entry, name);
+        return;
+    }
+
+    auto contents = os_read_entire_file(temp_arena(), from_path);
+    auto hash = content_hash(contents);
+
+    // NOTE(nick): prev can be the entry that manifest_put updates below
+    bool up_to_date = prev && prev->hash == hash && manifest_outputs_exist(prev);
+
+    auto entry = manifest_put(&ctx.manifest, input, hash, size, updated_at);
+    manifest_set_output(&ctx.manifest, entry, name);
+
+    if (up_to_date) return;
+
+    make_directory_recursive(path_basename(to_path));
+
+    replace_entire_file(to_path, contents);
+}
+
+void copy_public_files()
+{
+    auto public_dir = path_join(ctx.data_dir, S("public"));
+    auto files = scan_files_recursive(temp_arena(), public_dir);
+    for (Each_Node(it, files))
+    {
+        copy_public_file(it->name, it->size, it->updated_at);
+    }
+}
+
+// NOTE(nick): path is relative to the data dir
+bool read_page_source(Page *page)
+{
+    auto file = os_read_entire_file(temp_arena(), path_join(ctx.data_dir, page->path));
+    if (!file.data) return false;
+
+    // NOTE(nick): content and meta point into the source
+    string_free(&page->source);
+    page->source = string_alloc(file);
+
+    auto content = page->source;
+    auto yaml = find_yaml_frontmatter(content);
+    page->hash = content_hash(content);
+
+    string_advance(&content, yaml.count);
+
+    page->content   = content;
+    page->meta      = parse_page_meta(yaml);
+    page->meta_hash = content_hash(yaml);
+    return true;
+}
+
+Page *find_page_by_path(String path)
+{
+    return (Page *)lookup_find(&ctx.pages_by_path, path);
+}
+
+void load_page(Page *page, String path, String slug, String type)
+{
+    page->slug = slug;
+    page->type = type;
+    page->path = path;
+
+    page->prev_index = -1;
+    page->next_index = -1;
+
+    read_page_source(page);
+
+    // NOTE(nick): when the page list gets re-scanned in watch mode, pages that were already
+    // rendered don't need to be rendered again unless something they read changed
+    // (pages_by_path still points at the previous pages until load_pages is done)
+    Page *prev = find_page_by_path(path);
+    if (prev)
+    {
+        page->rendered      = prev->rendered;
+        page->rendered_hash = prev->rendered_hash;
+        page->deps          = prev->deps;
+        page->body          = prev->body;
+
+        prev->deps = NULL;
+        prev->body = NULL;
+    }
+}
+
+struct Page_Sort_Entry
+{
+    Dense_Time date;
+    i64 index; // into ctx.pages
+};
+
+i32 compare_page_sort_entries(void *a, void *b)
+{
+    auto ea = (Page_Sort_Entry *)a;
+    auto eb = (Page_Sort_Entry *)b;
+
+    if (ea->date != eb->date) return ea->date < eb->date ? -1 : 1;
+
+    // NOTE(nick): pages with the same date are ordered by slug so the order doesn't depend on the file system
+    String sa = ctx.pages[ea->index].slug;
+    String sb = ctx.pages[eb->index].slug;
+
+    i32 cmp = MemoryCompare(sa.data, sb.data, Min(sa.count, sb.count));
+    if (cmp != 0) return cmp;
+    if (sa.count != sb.count) return sa.count < sb.count ? -1 : 1;
+    return 0;
+}
+
+// NOTE(nick): the published pages of a type sorted oldest to newest
+// Every page of the type (drafts too) is linked to the published pages right before and after it,
+// so listing and navigation never have to skip over drafts.
+// view->indices has room for every page, load_pages allocates it next to the pages.
+void make_page_view(Page_View *view, String type)
+{
+    M_Temp temp = arena_begin_temp(temp_arena());
+
+    i64 count = 0;
+    for (Each_Page(it))
+    {
+        if (string_equals(it->type, type)) count += 1;
+    }
+
+    auto entries = PushArray(temp_arena(), Page_Sort_Entry, count);
+
+    i64 index = 0;
+    for (Each_Page(it))
+    {
+        if (!string_equals(it->type, type)) continue;
+
+        entries[index].date  = dense_time_from_date_time(ParsePostDate(it->meta.date));
+        entries[index].index = it - ctx.pages;
+        index += 1;
+
+    }
+
+    memory_sort(entries, count, sizeof(Page_Sort_Entry), compare_page_sort_entries);
+
+    view->count = 0;
+
+    i64 prev_index = -1;
+    for (i64 i = 0; i < count; i += 1)
+    {
+        Page *it = &ctx.pages[entries[i].index];
+        it->prev_index = prev_index;
+
+        if (it->meta.draft) continue;
+
+        view->indices[view->count] = entries[i].index;
+        view->count += 1;
+        prev_index = entries[i].index;
+    }
+
+    i64 next_index = -1;
+    for (i64 i = count - 1; i >= 0; i -= 1)
+    {
+        Page *it = &ctx.pages[entries[i].index];
+        it->next_index = next_index;
+
+        if (!it->meta.draft) next_index = entries[i].index;
+    }
+
+    arena_end_temp(temp);
+}
+
+void build_page_views()
+{
+    make_page_view(&ctx.posts,    S("post"));
+    make_page_view(&ctx.projects, S("project"));
+}
+
+// NOTE(nick): a markdown file that becomes a page, they're all found first so that the pages fit in one array
+struct Page_File
+{
+    String path;
+    String slug;
+    String type;
+
+    Page_File *next;
+};
+
+struct Page_File_List
+{
+    Page_File *first;
+    Page_File *last;
+    i64 count;
+};
+
+void push_page_file(Arena *arena, Page_File_List *list, String path, String slug, String type)
+{
+    Page_File *file = PushStructZero(arena, Page_File);
+    file->path = path;
+    file->slug = slug;
+    file->type = type;
+
+    QueuePush(list->first, list->last, file);
+    list->count += 1;
+}
+
+void load_pages()
+{
+    // NOTE(nick): every scan goes into the arena the last scan isn't in, load_page still needs the
+    // previous pages to carry over what was rendered
+    for (i64 i = 0; i < 2; i += 1)
+    {
+        if (!ctx.pages_arenas[i]) ctx.pages_arenas[i] = arena_alloc(Megabytes(64));
+    }
+
+    Swap(Arena *, ctx.pages_arenas[0], ctx.pages_arenas[1]);
+    Arena *arena = ctx.pages_arenas[0];
+    arena_reset(arena);
+
+    M_Temp temp = arena_begin_temp(temp_arena());
+
+    Page_File_List files = {};
+
+    //~nja: site pages
+    {
+        auto dir = path_join(ctx.data_dir, S("pages"));
+        auto iter = os_file_iter_begin(temp_arena(), dir);
+        File_Info it = {};
+        while (os_file_iter_next(temp_arena(), iter, &it))
+        {
+            if (os_file_is_directory(it)) continue;
+            if (!string_ends_with(it.name, S(".md"))) continue;
+
+            auto slug = PushStringCopy(arena, path_strip_extension(path_filename(it.name)));
+            push_page_file(arena, &files, path_join2(arena, S("pages"), it.name), slug, S("page"));
+        }
+
+        os_file_iter_end(iter);
+    }
+
+    // @Cleanup: make this dynamic?!
+    // It would be cool if we didn't have to specify these things every time!
+    // maybe it just reads from the folder name or something?
+    // :DynamicPageTypes
+
+    //~nja: site posts
+    {
+        auto dir = path_join(ctx.data_dir, S("posts"));
+        auto iter = os_file_iter_begin(temp_arena(), dir);
+        File_Info it = {};
+        while (os_file_iter_next(temp_arena(), iter, &it))
+        {
+            if (os_file_is_directory(it)) continue;
+            if (!string_ends_with(it.name, S(".md"))) continue;
+
+            auto slug = path_join2(arena, S("posts"), path_strip_extension(it.name));
+            push_page_file(arena, &files, path_join2(arena, S("posts"), it.name), slug, S("post"));
+        }
+
+        os_file_iter_end(iter);
+    }
+
+    // @Copypaste:
+    // :DynamicPageTypes
+
+    //~nja: site projects
+    {
+        auto dir = path_join(ctx.data_dir, S("projects"));
+        auto iter = os_file_iter_begin(temp_arena(), dir);
+        File_Info it = {};
+        while (os_file_iter_next(temp_arena(), iter, &it))
+        {
+            if (os_file_is_directory(it)) continue;
+            if (!string_ends_with(it.name, S(".md"))) continue;
+
+            auto slug = path_join2(arena, S("projects"), path_strip_extension(it.name));
+            push_page_file(arena, &files, path_join2(arena, S("projects"), it.name), slug, S("project"));
+        }
+
+        os_file_iter_end(iter);
+    }
+
+    Page *pages = PushArrayZero(arena, Page, files.count);
+    i64 page_count = 0;
+
+    for (Each_Node(file, files.first))
+    {
+        load_page(&pages[page_count], file->path, file->slug, file->type);
+        page_count += 1;
+    }
+
+    arena_end_temp(temp);
+
+    Page *prev_pages      = ctx.pages;
+    i64   prev_page_count = ctx.page_count;
+
+    ctx.pages      = pages;
+    ctx.page_count = page_count;
+
+    ctx.posts.indices    = PushArray(arena, i64, page_count);
+    ctx.projects.indices = PushArray(arena, i64, page_count);
+    build_page_views();
+
+    lookup_reset(&ctx.pages_by_path);
+    for (Each_Page(it)) lookup_add(&ctx.pages_by_path, it->path, it);
+
+    // NOTE(nick): load_page took the deps and bodies of the pages that are still around,
+    // the outputs of the ones that are gone get removed by remove_deleted_outputs
+    for (i64 i = 0; i < prev_page_count; i += 1)
+    {
+        Page *it = &prev_pages[i];
+        string_free(&it->source);
+        free_dependency_list(&it->deps);
+        free_markdown_cache_entry(&it->body);
+    }
+}
+
+// NOTE(nick): returns false if the page doesn't exist yet (or anymore) and the lists need to be re-scanned
+bool reload_page(String path)
+{
+    Page *page = find_page_by_path(path);
+    if (!page) return false;
+
+    u64 meta_hash = page->meta_hash;
+    if (!read_page_source(page)) return false;
+
+    // NOTE(nick): the date or draft flag might have changed, which moves the page around in its list
+    if (page->meta_hash != meta_hash) build_page_views();
+
+    return true;
+}
+
+bool path_is_page_source(String path)
+{
+    return string_ends_with(path, S(".md")) && (
+        string_starts_with(path, S("pages/")) ||
+        string_starts_with(path, S("posts/")) ||
+        string_starts_with(path, S("projects/")));
+}
+
+// NOTE(nick): pages that were deleted during this session, then pages and public files that were
+// deleted since the last run
+void remove_deleted_outputs()
+{
+    for (Manifest_Entry *it = ctx.manifest.first, *next = NULL; it != NULL; it = next)
+    {
+        next = it->next;
+        if (path_is_page_source(it->input) && !find_page_by_path(it->input)) remove_outputs(&ctx.manifest, it);
+    }
+
+    for (Manifest_Entry *it = ctx.prev_manifest.first, *next = NULL; it != NULL; it = next)
+    {
+        next = it->next;
+
+        bool is_source = path_is_page_source(it->input) || string_starts_with(it->input, S("public/"));
+        if (is_source && !manifest_find(&ctx.manifest, it->input)) remove_outputs(&ctx.prev_manifest, it);
+    }
+}
+
+void write_rss_feed()
+{
+    ctx.rss_feed = generate_blog_rss_feed(ctx.site, &ctx.posts);
+    replace_entire_file(path_join(ctx.output_dir, S("feed.xml")), ctx.rss_feed);
+}
+
+void write_site_pages(i64 job_count)
+{
+    write_asset_files();
+    build_dependency_table();
+    compile_page_shell();
+
+    write_all_pages(job_count);
+
+    i64 up_to_date_count = 0;
+    for (Each_Page(it))
+    {
+        if (it->up_to_date) up_to_date_count += 1;
+
+        auto entry = manifest_put(&ctx.manifest, it->path, it->hash);
+        manifest_set_output(&ctx.manifest, entry, sprint("%S.html", it->slug));
+        entry->deps = it->deps;
+    }
+
+    remove_deleted_outputs();
+
+    if (up_to_date_count)
+    {
+        print("  (%lld pages up to date)\n", up_to_date_count);
+    }
+
+    if (render_arena_pool.count)
+    {
+        print("  (%lld render arena sets, largest page used %.2fKB)\n", render_arena_pool.count, render_arena_pool.high_water_mark / 1024.0);
+    }
+}
+
+//
+// Gzip
+//
+// Text outputs get a precompressed .gz sibling so the server never has to compress anything.
+//
+
+bool output_is_compressible(String name)
+{
+    auto ext = path_extension(name);
+    return string_equals(ext, S(".html")) ||
+           string_equals(ext, S(".css"))  ||
+           string_equals(ext, S(".js"))   ||
+           string_equals(ext, S(".xml"))  ||
+           string_equals(ext, S(".svg"));
+}
+
+// NOTE(nick): stbi_zlib_compress makes a zlib stream, gzip wants the same deflate data with a different header and trailer
+String gzip_compress(Arena *arena, String data)
+{
+    int zlib_count = 0;
+    u8 *zlib = stbi_zlib_compress(data.data, (int)data.count, &zlib_count, 8);
+
+    // NOTE(nick): 2 byte zlib header, 4 byte adler32 trailer
+    if (!zlib || zlib_count < 6)
+    {
+        if (zlib) STBIW_FREE(zlib);
+        return {};
+    }
+
+    u64 deflate_count = zlib_count - 6;
+    u32 crc  = stbiw__crc32(data.data, (int)data.count);
+    u32 size = (u32)data.count;
+
+    String result = {};
+    result.count = 10 + deflate_count + 8;
+    result.data  = PushArray(arena, u8, result.count);
+
+    u8 header[10] = {0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 0xff};
+    MemoryCopy(result.data, header, sizeof(header));
+    MemoryCopy(result.data + 10, zlib + 2, deflate_count);
+
+    u8 *at = result.data + 10 + deflate_count;
+    for (int i = 0; i < 4; i += 1) at[i]     = (u8)(crc  >> (8 * i));
+    for (int i = 0; i < 4; i += 1) at[4 + i] = (u8)(size >> (8 * i));
+
+    STBIW_FREE(zlib);
+    return result;
+}
+
+void compress_output_files()
+{
+    // @Speed: go wide, although after the first build only a handful of files change
+    auto files = scan_files_recursive(temp_arena(), ctx.output_dir);
+    for (Each_Node(it, files))
+    {
+        if (!output_is_compressible(it->name)) continue;
+
+        auto input  = sprint("gzip:%S", it->name);
+        auto output = sprint("%S.gz", it->name);
+
+        // NOTE(nick): same as copy_public_file, trust the size and modified time of the uncompressed file
+        // In watch mode the last .gz is in ctx.manifest, otherwise it's in prev_manifest
+        auto prev = manifest_find(&ctx.manifest, input);
+        if (!prev) prev = manifest_find(&ctx.prev_manifest, input);
+
+        if (prev && prev->size == it->size && prev->updated_at == it->updated_at && manifest_outputs_exist(prev))
+        {
+            auto entry = manifest_put(&ctx.manifest, input, prev->hash, it->size, it->updated_at);
+            manifest_set_output(&ctx.manifest, entry, output);
+            continue;
+        }
+
+        auto contents = os_read_entire_file(temp_arena(), path_join(ctx.output_dir, it->name));
+        auto hash = content_hash(contents);
+
+        // NOTE(nick): prev might be the entry that manifest_put updates
+        bool up_to_date = prev && prev->hash == hash && manifest_outputs_exist(prev);
+
+        auto entry = manifest_put(&ctx.manifest, input, hash, it->size, it->updated_at);
+        manifest_set_output(&ctx.manifest, entry, output);
+
+        if (up_to_date) continue;
+
+        auto compressed = gzip_compress(temp_arena(), contents);
+        if (compressed.count)
+        {
+            replace_entire_file(path_join(ctx.output_dir, output), compressed);
+        }
+    }
+}
+
+bool save_build_manifest()
+{
+    manifest_compact(&ctx.manifest);
+
+    // NOTE(nick): the manifest lives outside of the output dir so that it never gets published
+    auto manifest_path = string_concat(ctx.output_dir, S(".manifest"));
+    if (!write_build_manifest(manifest_path, &ctx.manifest))
+    {
+        print("[warning] Failed to write build manifest: %S\n", manifest_path);
+        return false;
+    }
+
+    auto markdown_cache_path = string_concat(ctx.output_dir, S(".markdown_cache"));
+    if (!write_markdown_cache(markdown_cache_path))
+    {
+        print("[warning] Failed to write markdown cache: %S\n", markdown_cache_path);
+        return false;
+    }
+
+    return true;
+}
+
+
+//
+// Response Cache
+//
+// The server answers every request from an immutable snapshot of the output dir, so serving a
+// file never touches the disk. After each build a new snapshot is made and swapped in. Files
+// that didn't change are copied over from the previous snapshot instead of being read again,
+// so every snapshot owns all of its memory and is freed as soon as the last response using
+// it has been sent.
+//
+
+// NOTE(nick): a big file, opened when it was first put in a snapshot and shared by every later snapshot it's
+// unchanged in. Outputs are replaced by renaming (see replace_entire_file), so this keeps the old bytes around.
+struct Cached_File
+{
+    File file;
+    u64 volatile refs;
+};
+
+struct Cached_Response
+{
+    String name; // NOTE(nick): relative to the output dir
+    u64 size;
+    Dense_Time updated_at;
+
+    String headers; // NOTE(nick): preformatted Content-Type and Content-Length lines
+    String content_type;
+    String body;
+
+    // NOTE(nick): for conditional requests, not_modified_headers are the lines a 304 repeats
+    String etag;
+    Date_Time last_modified;
+    String not_modified_headers;
+
+    // NOTE(nick): big files are streamed from here with sendfile instead of being kept in body
+    String file_path;
+    Cached_File *file;
+    Cached_Response *next_file; // NOTE(nick): the snapshot's list of responses that hold a file
+};
+
+struct Cached_Url
+{
+    String url;
+    Cached_Response *response;
+    Cached_Response *gzip; // NOTE(nick): the .gz sibling, if there is one
+};
+
+struct Response_Cache
+{
+    Arena *arena; // NOTE(nick): the snapshot itself lives in here too
+    Table(u64, Cached_Url) urls;
+    Cached_Response *first_file;
+
+    // NOTE(nick): one for being the current snapshot, plus one for every response still being sent from it
+    u64 volatile refs;
+};
+
+static Http_Server global_server = {};
+
+// NOTE(nick): files bigger than this (resume PDFs, images) are left on disk
+static u64 response_cache_max_file_size = Kilobytes(256);
+
+// NOTE(nick): only the thread that builds the site swaps the snapshot, request threads take a reference under the lock
+static Mutex response_cache_mutex = {};
+static Response_Cache *global_response_cache = NULL;
+
+Response_Cache *response_cache_acquire()
+{
+    mutex_aquire_lock(&response_cache_mutex);
+
+    auto cache = global_response_cache;
+    if (cache) atomic_add_u64(&cache->refs, 1);
+
+    mutex_release_lock(&response_cache_mutex);
+
+    return cache;
+}
+
+void cached_file_release(Cached_File *file)
+{
+    if (atomic_add_u64(&file->refs, (u64)-1) == 1)
+    {
+        os_file_close(&file->file);
+        Free(file);
+    }
+}
+
+void response_cache_release(Response_Cache *cache)
+{
+    if (!cache) return;
+
+    if (atomic_add_u64(&cache->refs, (u64)-1) == 1)
+    {
+        for (auto it = cache->first_file; it != NULL; it = it->next_file)
+        {
+            cached_file_release(it->file);
+        }
+
+        table_free(&cache->urls);
+        arena_free(cache->arena);
+    }
+}
+
+void response_cache_release_proc(void *data)
+{
+    response_cache_release((Response_Cache *)data);
+}
+
+Cached_Url *response_cache_find(Response_Cache *cache, String url)
+{
+    if (!cache || !cache->urls.slots) return NULL;
+
+    u64 key = content_hash(url);
+    Cached_Url *result = (Cached_Url *)table_get(&cache->urls, table_hash_make(key), &key);
+
+    if (result && string_equals(result->url, url))
+    {
+        return result;
+    }
+
+    return NULL;
+}
+
+void response_cache_add(Response_Cache *cache, String url, Cached_Response *response, Cached_Response *gzip = NULL)
+{
+    Cached_Url it = {};
+    it.url      = url;
+    it.response = response;
+    it.gzip     = gzip;
+
+    u64 key = content_hash(url);
+    table_set(&cache->urls, table_hash_make(key), &key, &it);
+}
+
+// NOTE(nick): matches the names from write_asset_file, e.g. style.0123456789abcdef.css
+bool output_is_content_addressed(String name)
 {
-    auto file = request->url;
-    if (string_equals(file, S("/"))) file = S("index.html");
-    if (string_ends_with(file, S("/"))) file = string_slice(file, 0, file.count - 1);
+    if (string_ends_with(name, S(".gz"))) name = string_slice(name, 0, name.count - S(".gz").count);
 
-    auto ext = path_get_extension(file);
-    if (!ext.count) {
-        file = string_concat(file, S(".html"));
-        ext = S(".html");
-    }
+    i64 dot = string_find(name, S("."), 0, 0);
+    if (dot + 1 + 16 + 1 > name.count) return false;
 
-    auto file_path = path_join(global_public_path, file);
-    auto contents = os_read_entire_file(file_path);
-    if (!contents.data)
+    for (i64 i = dot + 1; i < dot + 1 + 16; i += 1)
     {
-        response->status_code = 404;
-        response->body = S("Not Found");
-        return;
+        u8 c = name.data[i];
+        if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'))) return false;
     }
 
-    response->status_code = 200;
-    response->body = contents;
-    response->content_type = http_content_type_from_extension(ext);
+    return name.data[dot + 1 + 16] == '.';
 }
 
-void run_server(String server_url, String public_path)
+// NOTE(nick): strong, so it's just the hash of the exact bytes we send
+String etag_from_contents(Arena *arena, String contents)
 {
-    socket_init();
-    
-    global_public_path = public_path;
-    http_server_run(server_url, request_callback);
+    return string_print(arena, "\"%016llx-%llx\"", content_hash(contents), contents.count);
+}
+
+Cached_Response *copy_cached_response(Arena *arena, Cached_Response *it)
+{
+    Cached_Response *response = PushStructZero(arena, Cached_Response);
+    *response = *it;
+
+    response->name                 = string_copy(arena, it->name);
+    response->headers              = string_copy(arena, it->headers);
+    response->body                 = string_copy(arena, it->body);
+    response->etag                 = string_copy(arena, it->etag);
+    response->not_modified_headers = string_copy(arena, it->not_modified_headers);
+    response->file_path            = string_copy(arena, it->file_path);
+    response->next_file            = NULL;
+
+    return response;
 }
 
+void response_cache_hold_file(Response_Cache *cache, Cached_Response *response)
+{
+    if (!response->file) return;
 
+    atomic_add_u64(&response->file->refs, 1);
+    response->next_file = cache->first_file;
+    cache->first_file   = response;
+}
 
-int main(int argc, char **argv)
+Cached_Response *load_cached_response(Response_Cache *cache, String name, u64 size, Dense_Time updated_at, Response_Cache *prev_cache)
 {
-    os_init();
+    auto arena = cache->arena;
+    auto url = sprint("/%S", name);
 
-    if (argc < 2) {
-        char *arg0 = argv[0];
-        print("Usage: %s <data> <bin>\n", arg0);
-        return -1;
+    // NOTE(nick): same as copy_public_file, if the size and modified time match we trust the old contents
+    auto found = response_cache_find(prev_cache, url);
+    auto prev = found ? found->response : NULL;
+    if (prev && prev->size == size && prev->updated_at == updated_at)
+    {
+        auto response = copy_cached_response(arena, prev);
+        response_cache_hold_file(cache, response);
+        return response;
     }
 
-    //~nja: parse arguments
-    auto exe_dir = os_get_executable_directory();
-
-    char *arg0 = argv[0];
-    char *arg1 = argv[1];
-    char *arg2 = argv[2];
+    auto path = path_join(ctx.output_dir, name);
 
-    auto data_dir   = path_resolve(exe_dir, string_from_cstr(arg1));
-    auto output_dir = path_resolve(exe_dir, string_from_cstr(arg2));
+    Cached_Response *response = PushStructZero(arena, Cached_Response);
+    u64 content_length = size;
 
-    ctx.data_dir   = data_dir;
-    ctx.output_dir = output_dir;
+    if (size > response_cache_max_file_size)
+    {
+        // NOTE(nick): the etag is made from the same open file the responses are sent from
+        File file = os_file_open(path, FileMode_Read);
+        if (file.has_errors) return NULL;
 
-    os_make_directory(output_dir);
+        M_Temp temp = arena_begin_temp(temp_arena());
 
-    auto yaml = os_read_entire_file(path_join(data_dir, S("site.yaml")));
+        content_length = os_file_get_size(file);
+        String contents = string_make(PushArray(temp_arena(), u8, content_length), content_length);
+        os_file_read(&file, 0, contents.count, contents.data);
 
-    Site_Meta site = parse_site_info(yaml);
-    ctx.site = site;
+        if (file.has_errors)
+        {
+            arena_end_temp(temp);
+            os_file_close(&file);
+            return NULL;
+        }
 
-    // @Speed: go wide on reading all data files
+        response->etag = etag_from_contents(arena, contents);
 
-    auto css = os_read_entire_file(path_join(data_dir, S("style.css")));
-    css = minify_css(css);
+        arena_end_temp(temp);
 
-    auto js = os_read_entire_file(path_join(data_dir, S("script.js")));
-    js = minify_js(js);
+        response->file_path  = string_copy(arena, path);
+        response->file       = New(Cached_File, 1);
+        response->file->file = file;
+        response->file->refs = 0;
+        response_cache_hold_file(cache, response);
 
-    //~nja: static assets
-    print("[before assets] %.2fms\n", os_time_in_miliseconds());
+        // NOTE(nick): the file might have changed since it was listed, this is the size we're going to send
+        size = content_length;
+    }
+    else
     {
-        auto public_dir = path_join(data_dir, S("public"));
-        auto files = os_scan_files_recursive(public_dir);
-        Forp (files)
-        {
-            auto from_path = path_join(public_dir, it->name);
-            auto to_path = path_join(output_dir, it->name);
-            auto contents = os_read_entire_file(from_path);
+        response->body = os_read_entire_file(arena, path);
+        if (!response->body.data) return NULL;
 
-            os_make_directory_recursive(path_dirname(to_path));
-
-            os_write_entire_file(to_path, contents);
-        }
+        response->etag = etag_from_contents(arena, response->body);
+        content_length = response->body.count;
     }
-    print("[after assets] %.2fms\n", os_time_in_miliseconds());
 
+    // NOTE(nick): file times aren't in the same units on every platform, so this is when we first saw these bytes
+    response->last_modified = os_get_current_time_in_utc();
+    response->last_modified.msec = 0;
 
-    //~nja: site pages
-    {
-        auto dir = path_join(data_dir, S("pages"));
-        auto iter = os_file_list_begin(temp_arena(), dir);
-        File_Info it = {};
-        while (os_file_list_next(&iter, &it))
-        {
-            if (file_is_directory(it)) continue;
-            if (!string_ends_with(it.name, S(".md"))) continue;
+    // NOTE(nick): a .gz sibling is served as its uncompressed type
+    auto gzipped = string_ends_with(name, S(".gz"));
+    auto original_name = gzipped ? string_slice(name, 0, name.count - S(".gz").count) : name;
 
-            auto page_file = path_join(dir, it.name);
-            auto content   = os_read_entire_file(page_file);
-            auto yaml      = find_yaml_frontmatter(content);
+    // NOTE(nick): not {}, %S prints a String without any data as "null"
+    String encoding = S("");
+    if (gzipped) encoding = S("Content-Encoding: gzip\r\n");
+    if (output_is_compressible(original_name)) encoding = string_concat(encoding, S("Vary: Accept-Encoding\r\n"));
 
-            string_advance(&content, yaml.count);
+    // NOTE(nick): no-cache means browsers always ask, they just get a 304 back when nothing changed
+    auto cache_control = S("no-cache");
+    if (output_is_content_addressed(original_name)) cache_control = S("public, max-age=31536000, immutable");
 
-            Page *page    = PushStruct(temp_arena(), Page);
-            page->slug    = PushStringCopy(temp_arena(), path_strip_extension(path_filename(it.name)));
-            page->content = content;
-            page->meta    = parse_page_meta(yaml);
-            page->type    = S("page");
+    auto validators = sprint("ETag: %S\r\nLast-Modified: %S\r\nCache-Control: %S\r\n%S",
+        response->etag, http_date_string(temp_arena(), response->last_modified), cache_control, encoding);
 
-            DLLPushBack(ctx.pages, ctx.last_page, page);
-        }
+    response->name                 = string_copy(arena, name);
+    response->size                 = size;
+    response->updated_at           = updated_at;
+    response->content_type         = http_content_type_from_extension(path_extension(original_name));
+    response->headers              = string_print(arena, "Content-Type: %S\r\n%SAccept-Ranges: bytes\r\nContent-Length: %llu\r\n", response->content_type, validators, content_length);
+    response->not_modified_headers = string_copy(arena, validators);
 
-        os_file_list_end(&iter);
-    }
+    return response;
+}
 
-    // @Cleanup: make this dynamic?!
-    // It would be cool if we didn't have to specify these things every time!
-    // maybe it just reads from the folder name or something?
-    // :DynamicPageTypes
+// NOTE(nick): called after every build, requests that are already being answered keep using the old snapshot
+void update_response_cache()
+{
+    if (!response_cache_mutex.handle) response_cache_mutex = mutex_create(0);
 
-    //~nja: site posts
-    {
-        auto dir = path_join(data_dir, S("posts"));
-        auto iter = os_file_list_begin(temp_arena(), dir);
-        File_Info it = {};
-        while (os_file_list_next(&iter, &it))
-        {
-            if (file_is_directory(it)) continue;
-            if (!string_ends_with(it.name, S(".md"))) continue;
+    Response_Cache *prev_cache = global_response_cache;
 
-            auto post_file = path_join(dir, it.name);
-            auto content   = os_read_entire_file(post_file);
-            auto yaml      = find_yaml_frontmatter(content);
+    auto arena = arena_alloc(Gigabytes(64));
 
-            string_advance(&content, yaml.count);
+    Response_Cache *cache = PushStructZero(arena, Response_Cache);
+    cache->arena = arena;
+    cache->refs  = 1;
+    table_init(&cache->urls, sizeof(u64), sizeof(Cached_Url));
 
-            Page *page    = PushStruct(temp_arena(), Page);
-            page->slug    = path_join(temp_arena(), S("posts"), path_strip_extension(it.name));
-            page->content = content;
-            page->meta    = parse_page_meta(yaml);
-            page->type    = S("post");
+    auto files = scan_files_recursive(temp_arena(), ctx.output_dir);
 
-            DLLPushBack(ctx.pages, ctx.last_page, page);
+    // NOTE(nick): load the .gz siblings first so that every url of a file can point at its variant
+    Response_Cache gzip_variants = {};
+    table_init(&gzip_variants.urls, sizeof(u64), sizeof(Cached_Url));
 
-            Page *copy = PushStruct(temp_arena(), Page);
-            memory_copy(page, copy, sizeof(Page));
-            DLLPushBack(ctx.posts, ctx.last_post, copy);
-        }
+    for (Each_Node(it, files))
+    {
+        if (!string_ends_with(it->name, S(".gz"))) continue;
 
-        os_file_list_end(&iter);
-    }
+        auto response = load_cached_response(cache, it->name, it->size, it->updated_at, prev_cache);
+        if (!response) continue;
 
-    // @Copypaste:
-    // :DynamicPageTypes
+        auto name = response->name;
+        response_cache_add(cache, string_print(arena, "/%S", name), response);
+        response_cache_add(&gzip_variants, sprint("/%S", string_slice(name, 0, name.count - S(".gz").count)), response);
+    }
 
-    //~nja: site projects
+    for (Each_Node(it, files))
     {
-        auto dir = path_join(data_dir, S("projects"));
-        auto iter = os_file_list_begin(temp_arena(), dir);
-        File_Info it = {};
-        while (os_file_list_next(&iter, &it))
-        {
-            if (file_is_directory(it)) continue;
-            if (!string_ends_with(it.name, S(".md"))) continue;
+        if (string_ends_with(it->name, S(".gz"))) continue;
 
-            auto post_file = path_join(dir, it.name);
-            auto content   = os_read_entire_file(post_file);
-            auto yaml      = find_yaml_frontmatter(content);
+        auto response = load_cached_response(cache, it->name, it->size, it->updated_at, prev_cache);
+        if (!response) continue;
 
-            string_advance(&content, yaml.count);
+        auto name = response->name;
 
-            Page *page    = PushStruct(temp_arena(), Page);
-            page->slug    = path_join(temp_arena(), S("projects"), path_strip_extension(it.name));
-            page->content = content;
-            page->meta    = parse_page_meta(yaml);
-            page->type    = S("project");
+        auto variant = response_cache_find(&gzip_variants, sprint("/%S", name));
+        auto gzip = variant ? variant->response : NULL;
 
-            DLLPushBack(ctx.pages, ctx.last_page, page);
+        response_cache_add(cache, string_print(arena, "/%S", name), response, gzip);
 
-            Page *copy = PushStruct(temp_arena(), Page);
-            memory_copy(page, copy, sizeof(Page));
-            DLLPushBack(ctx.projects, ctx.last_project, copy);
-        }
+        // NOTE(nick): pages are also served without the extension, with or without a trailing slash
+        if (string_ends_with(name, S(".html")))
+        {
+            auto stem = string_slice(name, 0, name.count - S(".html").count);
+            response_cache_add(cache, string_print(arena, "/%S", stem), response, gzip);
+            response_cache_add(cache, string_print(arena, "/%S/", stem), response, gzip);
 
-        os_file_list_end(&iter);
+            if (string_equals(name, S("index.html")))
+            {
+                response_cache_add(cache, S("/"), response, gzip);
+            }
+        }
     }
 
+    table_free(&gzip_variants.urls);
 
-    //~nja: generate RSS feed
-    auto rss_feed = generate_blog_rss_feed(site, ctx.posts);
-    os_write_entire_file(path_join(output_dir, S("feed.xml")), rss_feed);
-
-    //~nja: output site pages
-    os_make_directory(path_join(output_dir, S("posts")));
-    os_make_directory(path_join(output_dir, S("projects")));
+    mutex_aquire_lock(&response_cache_mutex);
+    global_response_cache = cache;
+    mutex_release_lock(&response_cache_mutex);
 
-    print("[time] %.2fms\n", os_time_in_miliseconds());
-    print("Generating Pages...\n");
+    // NOTE(nick): freed here, or by the last response that is still being sent from it
+    response_cache_release(prev_cache);
+}
 
-    for (Each_Page(it, ctx.pages))
+HTTP_REQUEST_CALLBACK(request_callback)
+{
+    if (string_equals(request->url, S("/_live_reload")))
     {
-        print("  %S\n", it->slug);
-
-        auto page = it->meta;
-        auto meta = it->meta;
-
-        if (!meta.title.count)       meta.title = site.name;
-        if (!meta.description.count) meta.description = site.description;
-        if (!meta.image.count)       meta.image = site.image;
-        if (!meta.og_type.count)     meta.og_type = site.og_type;
-
-        Arena *arena = arena_alloc_from_memory(megabytes(16));
-
-        //~nja: html template
+        // NOTE(nick): tell the browser to reconnect quickly if the server restarts
+        response->event_stream = true;
+        response->body = S("retry: 500\n\n");
+        return;
+    }
 
-        write(arena, "<!DOCTYPE html>\n");
-        write(arena, "<html lang='en'>\n");
+    auto url = request->url;
 
-        write(arena, "<head>\n");
-        write(arena, "<meta charset='utf-8' />\n");
-        write(arena, "<meta name='viewport' content='width=device-width, initial-scale=1' />\n");
+    i64 query_index = string_find(url, S("?"), 0, 0);
+    if (query_index < url.count) url = string_slice(url, 0, query_index);
 
-        write(arena, "<title>%S</title>\n", meta.title);
-        write(arena, "<meta name='description' content='%S' />\n", meta.description);
+    // NOTE(nick): body and headers point into the snapshot, so it's held until the server has sent them
+    auto cache = response_cache_acquire();
+    response->done      = response_cache_release_proc;
+    response->done_data = cache;
 
-        write(arena, "<meta itemprop='name' content='%S'>\n", meta.title);
-        write(arena, "<meta itemprop='description' content='%S'>\n", meta.description);
-        write(arena, "<meta itemprop='image' content='%S'>\n", meta.image);
+    auto found = response_cache_find(cache, url);
+    if (!found)
+    {
+        response->status_code = 404;
+        response->body = S("Not Found");
+        return;
+    }
 
-        write(arena, "<meta property='og:title' content='%S' />\n", meta.title);
-        write(arena, "<meta property='og:description' content='%S' />\n", meta.description);
-        write(arena, "<meta property='og:type' content='%S' />\n", meta.og_type);
-        write(arena, "<meta property='og:url' content='%S' />\n", meta.url);
-        write(arena, "<meta property='og:site_name' content='%S' />\n", site.name);
-        write(arena, "<meta property='og:locale' content='en_us' />\n");
+    auto cached = found->response;
 
-        write(arena, "<meta name='twitter:card' content='summary' />\n");
-        write(arena, "<meta name='twitter:title' content='%S' />\n", meta.title);
-        write(arena, "<meta name='twitter:description' content='%S' />\n", meta.description);
-        write(arena, "<meta name='twitter:image' content='%S' />\n", meta.image);
-        write(arena, "<meta name='twitter:site' content='%S' />\n", site.twitter_handle);
+    // @Incomplete: q-values, "gzip;q=0" is treated as accepting gzip
+    auto accept_encoding = http_find_header(request->headers, S("Accept-Encoding"));
+    if (found->gzip && string_find(accept_encoding, S("gzip"), 0, MatchFlag_IgnoreCase) < accept_encoding.count)
+    {
+        cached = found->gzip;
+    }
 
-        //write(arena, "<link rel='icon' type='image/png' href='%S' sizes='%dx%d' />\n", asset_path, size, size);
+    // NOTE(nick): If-Modified-Since is only looked at when there is no If-None-Match
+    bool not_modified = false;
 
-        if (site.theme_color.count)
+    auto if_none_match = http_find_header(request->headers, S("If-None-Match"));
+    if (if_none_match.count)
+    {
+        not_modified = http_etag_matches(if_none_match, cached->etag);
+    }
+    else
+    {
+        Date_Time if_modified_since = {};
+        if (http_parse_date(http_find_header(request->headers, S("If-Modified-Since")), &if_modified_since))
         {
-        write(arena, "<meta name='theme-color' content='%S' />\n", site.theme_color);
-        write(arena, "<meta name='msapplication-TileColor' content='%S' />\n", site.theme_color);
+            not_modified = dense_time_from_date_time(if_modified_since) >= dense_time_from_date_time(cached->last_modified);
         }
+    }
 
-        write(arena, "<link rel='shortcut icon' href='/favicon.png' sizes='32x32' />\n");
+    if (not_modified)
+    {
+        response->status_code = 304;
+        response->raw_headers = cached->not_modified_headers;
+        return;
+    }
+
+    auto range = http_find_header(request->headers, S("Range"));
+    if (range.count && string_equals(request->method, S("GET")))
+    {
+        // NOTE(nick): If-Range means "only the parts if it's still this version, otherwise all of it"
+        bool use_range = true;
 
-        if (css.count)
+        auto if_range = http_find_header(request->headers, S("If-Range"));
+        if (if_range.count)
         {
-        write(arena, "<style type='text/css'>%S</style>\n", css);
+            Date_Time if_range_date = {};
+            if (string_starts_with(if_range, S("\"")))
+            {
+                use_range = string_equals(if_range, cached->etag);
+            }
+            else if (http_parse_date(if_range, &if_range_date))
+            {
+                use_range = dense_time_from_date_time(if_range_date) == dense_time_from_date_time(cached->last_modified);
+            }
+            else
+            {
+                use_range = false;
+            }
         }
 
-        if (rss_feed.count)
+        if (use_range)
         {
-        write(arena, "<link rel='alternate' type='application/rss+xml' title='Nick Aversano' href='%S/feed.xml' />\n", site.url);
+            u64 content_size = cached->file_path.count ? cached->size : cached->body.count;
+
+            i64 range_count = http_parse_ranges(range, content_size, response->ranges, count_of(response->ranges));
+            if (range_count < 0)
+            {
+                response->status_code = 416;
+                response->raw_headers = sprint("Content-Range: bytes */%llu\r\nContent-Length: 0\r\n", content_size);
+                return;
+            }
+
+            // NOTE(nick): the validators go along with the 206, the part headers are made by the server
+            if (range_count > 0)
+            {
+                response->range_count  = range_count;
+                response->raw_headers  = cached->not_modified_headers;
+                response->body         = cached->body;
+                response->content_type = cached->content_type;
+                response->file_path    = cached->file_path;
+                response->file_size    = cached->size;
+                response->file         = cached->file ? &cached->file->file : NULL;
+                return;
+            }
         }
+    }
 
-        write(arena, "</head>\n");
-        //~nja: body
-        write(arena, "<body class='%S'>\n", meta.title);
+    response->status_code  = 200;
+    response->body         = cached->body;
+    response->content_type = cached->content_type;
+    response->raw_headers  = cached->headers;
+    response->file_path    = cached->file_path;
+    response->file_size    = cached->size;
+    response->file         = cached->file ? &cached->file->file : NULL;
+}
 
-        //~nja: header
-        write(arena, "<div class='content flex-x pad-64  xs:flex-y sm:csy-8 sm:pad-32'>\n");
-            write(arena, "<div class='csx-16 flex-1 flex-x center-y'>\n");
-                write(arena, "<span class='font-24 font-bold'><a href='%S'>%S</a></span>\n", S("/"), site.name);
-            write(arena, "</div>\n");
+bool start_server(String server_url)
+{
+    socket_init();
 
-            write(arena, "<div class='csx-16 flex-x'>\n");
+    global_server = http_server_init(server_url);
 
-            for (Each_Link(it, ctx.site.social_icons))
-            {
-                auto name  = it->title;
-                auto image = it->desc;
-                auto url   = it->href;
+    if (!socket_is_valid(global_server.socket))
+    {
+        print("Failed to start HTTP server at %S\n", server_url);
+        return false;
+    }
 
-                auto content = os_read_entire_file(path_join(data_dir, image));
+    return true;
+}
 
-                write(arena, "<a title='%S' href='%S' target='_blank' class='inline-flex center pad-8'><div class='inline-block size-20'>%S</div></a>\n", name, url, content);
-            }
-            write(arena, "</div>\n");
-        write(arena, "</div>\n");
+void run_server()
+{
+    http_server_serve(&global_server, request_callback);
+}
 
-        //~nja: image header / banner
-        if (page.image.count)
+THREAD_PROC(run_server_thread)
+{
+    run_server();
+    return 0;
+}
+
+//
+// Watch Mode
+//
+// Everything that was loaded for the first build stays in memory. When a file in the data dir
+// changes we only re-read that file, then the dependency table tells us which pages to render.
+//
+
+void watch_data_dir(i64 job_count)
+{
+    Arena *watcher_arena = arena_alloc(Megabytes(16));
+    File_Watcher *watcher = os_file_watcher_begin(watcher_arena, ctx.data_dir);
+
+    print("Watching %S for changes...\n", ctx.data_dir);
+
+    for (;;)
+    {
+        // NOTE(nick): anything that has to outlive a rebuild is copied out of the temp arena
+        // (pages, the manifest, markdown bodies and deps all own their memory)
+        M_Temp temp = arena_begin_temp(temp_arena());
+
+        String_List changed = {};
+        if (!os_file_watcher_wait(temp_arena(), watcher, &changed, -1))
         {
-        write(arena, "<div class='hero w-full bg-light'>\n");
-            write_image(arena, page.image, S(""), S("class='cover'"));
-        write(arena, "</div>\n");
+            arena_end_temp(temp);
+            continue;
         }
 
-        // @Incomplete: we can actually make this work for other types of things too!
-        //~nja: post next / prev links
-        auto post = find_page_by_slug(it, ctx.posts);
-        if (post)
+        f64 start_time = os_time_in_miliseconds();
+
+        bool rescan_pages = false;
+        bool feed_changed = false;
+        bool public_changed = false;
+
+        for (String_Node *node = changed.first; node != NULL; node = node->next)
         {
-            auto links = find_next_and_prev_pages(post);
-            write(arena, "<div class='content padx-64 sm:padx-32 h-64 flex-x center-y csx-32' style='margin-bottom: -2rem'>");
-                if (links.prev)
+            String path = node->string;
+
+            if (false) {}
+            else if (path.count == 0)
+            {
+                // NOTE(nick): the watcher lost track of what changed, so re-read everything like the first build
+                load_site_meta();
+                load_styles();
+                load_scripts();
+                copy_public_files();
+                invalidate_included_files();
+
+                rescan_pages   = true;
+                feed_changed   = true;
+                public_changed = true;
+            }
+            else if (string_starts_with(path, S("public/")))
+            {
+                String name = string_slice(path, S("public/").count, path.count);
+                String from_path = path_join(ctx.data_dir, path);
+                public_changed = true;
+
+                if (os_file_exists(from_path))
                 {
-                    write(arena, "<a class='font-bold pady-16' href='%S'>← Prev</a>", post_link(links.prev));
+                    File_Info info = os_get_file_info(from_path);
+                    if (!os_file_is_directory(info)) copy_public_file(name, info.size, info.updated_at);
                 }
-                if (links.next)
+                else
                 {
-                    write(arena, "<a class='font-bold pady-16 align-right' href='%S'>Next →</a>", post_link(links.next));
+                    auto entry = manifest_find(&ctx.manifest, path);
+                    if (entry) remove_outputs(&ctx.manifest, entry);
+                    else       os_delete_file(path_join(ctx.output_dir, name));
                 }
-            write(arena, "</div>\n");
+            }
+            else if (string_equals(path, S("site.yaml")))
+            {
+                load_site_meta();
+                feed_changed = true;
+            }
+            else if (string_equals(path, S("style.css")))
+            {
+                load_styles();
+            }
+            else if (string_equals(path, S("script.js")))
+            {
+                load_scripts();
+            }
+            else if (path_is_page_source(path))
+            {
+                if (!reload_page(path)) rescan_pages = true;
+                if (string_starts_with(path, S("posts/"))) feed_changed = true;
+            }
+
+            // NOTE(nick): anything else (e.g. icons) is re-read and re-hashed by build_dependency_table
+            invalidate_included_file(path);
         }
 
-        //~nja: project next / prev links
-        auto project = find_page_by_slug(it, ctx.projects);
-        if (project)
+        if (rescan_pages) load_pages();
+        if (feed_changed) write_rss_feed();
+
+        write_site_pages(job_count);
+        compress_output_files();
+        save_build_manifest();
+
+        print("Rebuilt in %.2fms\n", os_time_in_miliseconds() - start_time);
+
+        if (ctx.live_reload)
         {
-            auto links = find_next_and_prev_pages(project);
-            write(arena, "<div class='content padx-64 sm:padx-32 h-64 flex-x center-y csx-32' style='margin-bottom: -2rem'>");
-                if (links.prev)
-                {
-                    write(arena, "<a class='font-bold pady-16' href='%S'>← Prev</a>", post_link(links.prev));
-                }
-                if (links.next)
+            update_response_cache();
+
+            // NOTE(nick): every change goes out in one message, so each client is written to once per rebuild
+            String_List events = {};
+            if (public_changed)
+            {
+                string_list_push(temp_arena(), &events, http_event_message(temp_arena(), S("change"), S("*")));
+            }
+            else
+            {
+                for (Each_Page(it))
                 {
-                    write(arena, "<a class='font-bold pady-16 align-right' href='%S'>Next →</a>", post_link(links.next));
+                    if (!it->up_to_date) string_list_push(temp_arena(), &events, http_event_message(temp_arena(), S("change"), sprint("/%S", it->slug)));
                 }
-            write(arena, "</div>\n");
+            }
+
+            if (events.node_count) http_server_send_events(&global_server, string_list_join(temp_arena(), events, S("")));
         }
 
+        arena_end_temp(temp);
+    }
+
+    os_file_watcher_end(watcher);
+}
+
+
+int main(int argc, char **argv)
+{
+    os_init();
+
+    if (argc < 3) {
+        char *arg0 = argv[0];
+        print("Usage: %s <data> <bin> [--serve | --open] [--watch] [--jobs N] [--assets auto|inline|external] [--critical-css] [--force]\n", arg0);
+        return -1;
+    }
+
+    //~nja: parse arguments
+    auto exe_dir = os_get_executable_path();
+
+    char *arg0 = argv[0];
+    char *arg1 = argv[1];
+    char *arg2 = argv[2];
+
+    bool serve = false;
+    bool open  = false;
+    bool force = false;
+    bool watch = false;
+    i64 job_count = 1;
+
+    for (int i = 3; i < argc; i += 1)
+    {
+        auto arg = string_from_cstr(argv[i]);
 
-        //~nja: page content
-        write(arena, "<div id='content' class='content pad-64 sm:pad-32'>\n");
+        if (false) {}
+        else if (string_equals(arg, S("--serve"))) { serve = true; }
+        else if (string_equals(arg, S("--open")))  { open = true; }
+        else if (string_equals(arg, S("--force"))) { force = true; }
+        else if (string_equals(arg, S("--watch"))) { watch = true; }
+        else if (string_equals(arg, S("--critical-css"))) { ctx.critical_css = true; }
+        else if (string_equals(arg, S("--jobs")) && i + 1 < argc)
+        {
+            i += 1;
+            job_count = string_to_i64(string_from_cstr(argv[i]), 10);
 
-            //~nja: page header
-            if (page.title.count || page.date.count)
+            // NOTE(nick): every job renders into its own set of render arenas
+            if (job_count > RENDER_ARENA_MAX_SETS)
             {
-            write(arena, "<div class='marb-32'>\n", page.title);
-                if (string_contains(it->slug, S("posts/")))
-                {
-                    i64 words = string_count_words(it->content);
-                    i64 avg_read_time_mins = (i64)((words / 300.0f) + 0.5f);
-                    if (avg_read_time_mins > 0)
-                    {
-                        write(arena, "<div class='c-gray' style='font-size:0.8rem'>%d min read</div>\n", avg_read_time_mins);
-                    }
-                    else
-                    {
-                        write(arena, "<div class='c-gray' style='font-size:0.8rem'>&lt;1 min read</div>\n", avg_read_time_mins);
-                    }
-                }
-                if (page.title.count)
-                {
-                    write(arena, "<h1>%S</h1>\n", page.title);
-                }
-                if (page.date.count)
-                {
-                    write(arena, "<div class='c-gray'>%S</div>\n", pretty_date(ParsePostDate(page.date)));
-                }
-                if (page.author.count)
-                {
-                    Link *author = find_link_by_title(page.author, ctx.site.authors);
-                    if (author)
-                    {
-                        write(arena, "<div>By <a class='font-bold link' href='%S'>%S</a></div>\n",
-                            author->href, author->title);
-                    }
-                    else
-                    {
-                        write(arena, "<div>By <span class='font-bold'>%S</span></div>\n", page.author);
-                    }
-                }
-            write(arena, "</div>\n", page.title);
+                print("[warning] --jobs is capped at %d\n", RENDER_ARENA_MAX_SETS);
             }
+            job_count = Clamp(job_count, 1, RENDER_ARENA_MAX_SETS);
+        }
+        else if (string_equals(arg, S("--assets")) && i + 1 < argc)
+        {
+            i += 1;
+            auto mode = string_from_cstr(argv[i]);
 
-            write(arena, "%S", markdown_to_html(it->content));
+            if (false) {}
+            else if (string_equals(mode, S("auto")))     { ctx.asset_mode = AssetMode_Auto; }
+            else if (string_equals(mode, S("inline")))   { ctx.asset_mode = AssetMode_Inline; }
+            else if (string_equals(mode, S("external"))) { ctx.asset_mode = AssetMode_External; }
+            else
+            {
+                print("[warning] Unknown asset mode: %S\n", mode);
+            }
+        }
+        else
+        {
+            print("[warning] Unknown argument: %S\n", arg);
+        }
+    }
 
-        write(arena, "</div>\n");
+    ctx.live_reload = serve && watch;
 
-        //~nja: footer
-        write(arena, "<div class='content pad-64 w-800 sm:pad-32 flex-y center-x'>\n");
+    // NOTE(nick): relative paths are relative to the executable
+    auto data_dir   = string_from_cstr(arg1);
+    auto output_dir = string_from_cstr(arg2);
+    if (!path_is_absolute(data_dir))   data_dir   = path_join(exe_dir, data_dir);
+    if (!path_is_absolute(output_dir)) output_dir = path_join(exe_dir, output_dir);
 
-        write(arena, "<a class='pad-16' onclick='toggle()'>💡</a>\n");
+    ctx.data_dir   = data_dir;
+    ctx.output_dir = output_dir;
 
-        write(arena, "<div style='min-width: 64px; max-width: 64px; margin-bottom: -64px'>\n");
-        write_image(arena, S("guy_pixel.png"), S("Guy"));
-        write(arena, "</div>\n");
+    os_make_directory(output_dir);
 
-        write(arena, "</div>\n");
+    if (!force)
+    {
+        ctx.prev_manifest = read_build_manifest(string_concat(output_dir, S(".manifest")));
+        ctx.prev_markdown_cache = read_markdown_cache(string_concat(output_dir, S(".markdown_cache")));
+    }
+
+    // @Speed: go wide on reading all data files
+
+    load_site_meta();
+    load_styles();
+    load_scripts();
 
-        write(arena, "<script>%S</script>\n", js);
-        write(arena, "<script src='/lightning.js'></script>\n");
+    //~nja: static assets
+    print("[before assets] %.2fms\n", os_time_in_miliseconds());
+    copy_public_files();
+    print("[after assets] %.2fms\n", os_time_in_miliseconds());
 
-        write(arena, "</body>\n");
+    load_pages();
 
-        write(arena, "</html>\n");
+    //~nja: generate RSS feed
+    write_rss_feed();
 
-        auto html = arena_to_string(arena);
-        assert(os_write_entire_file(path_join(output_dir, sprint("%S.html", it->slug)), html));
-    }
+    //~nja: output site pages
+    os_make_directory(path_join(output_dir, S("posts")));
+    os_make_directory(path_join(output_dir, S("projects")));
 
+    print("[time] %.2fms\n", os_time_in_miliseconds());
+    print("Generating Pages...\n");
 
-    // TODO(nick): we can go wide here and write all the files in parallel
-    // @Speed: go wide on writing all output files
+    write_site_pages(job_count);
+    compress_output_files();
+    save_build_manifest();
 
     print("Done! Took %.2fms\n", os_time_in_miliseconds());
 
-    if (argc >= 3)
+    // TODO(nick): allow the browser to be customized
+
+    if (serve)
     {
-        // TODO(nick): allow the browser to be customized
-        
-        auto arg3 = string_from_cstr(argv[3]);
+        os_shell_execute(S("firefox.exe"), S("http://localhost:3000"), false);
+
+        update_response_cache();
 
-        if (string_equals(arg3, S("--serve")))
+        if (!start_server(S("127.0.0.1:3000"))) return -1;
+
+        if (watch)
         {
-            os_shell_execute(S("firefox.exe"), S("http://localhost:3000"));
-            
-            auto public_path = string_alloc(os_allocator(), output_dir);
-            run_server(S("127.0.0.1:3000"), public_path);
+            // NOTE(nick): watch_data_dir swaps in a new response cache after every rebuild
+            Thread thread = thread_create(run_server_thread, NULL, 0);
+            thread_detach(thread);
         }
-
-        if (string_equals(arg3, S("--open")))
+        else
         {
-            os_shell_execute(S("firefox.exe"), path_join(S("file://"), output_dir, S("index.html")));
+            run_server();
         }
     }
 
+    if (open)
+    {
+        os_shell_execute(S("firefox.exe"), path_join3(temp_arena(), S("file://"), output_dir, S("index.html")), false);
+    }
+
+    if (watch)
+    {
+        watch_data_dir(job_count);
+    }
+
     return 0;
-}
\ No newline at end of file
+}
@@ -213,9 +213,12 @@ static const int __arch_endian_check_num = 1;
     #define __PrintFunction(x,y)
 #endif
 
-#if __has_feature(address_sanitizer)
-    #ifndef __SANITIZE_ADDRESS__
-    #define __SANITIZE_ADDRESS__
+// NOTE(nick): GCC doesn't have __has_feature, it defines __SANITIZE_ADDRESS__ itself
+#if defined(__has_feature)
+    #if __has_feature(address_sanitizer)
+        #ifndef __SANITIZE_ADDRESS__
+        #define __SANITIZE_ADDRESS__
+        #endif
     #endif
 #endif
 
@@ -224,7 +227,27 @@ static const int __arch_endian_check_num = 1;
     #define __AsanUnpoisonMemoryRegion(addr, size) __asan_unpoison_memory_region((addr), (size))
 #else
     #define __AsanPoisonMemoryRegion(addr, size) ((void)(addr), (void)(size))
-    #define __AsanUnpoisonMemoryRegion(addr, size) ((void)(addr)
+    #define __AsanUnpoisonMemoryRegion(addr, size) ((void)(addr), (void)(size))
+#endif
+
+//
+// SIMD
+//
+
+#if !defined(SIMD_AVX2)
+    #if defined(__AVX2__)
+        #define SIMD_AVX2 1
+    #else
+        #define SIMD_AVX2 0
+    #endif
+#endif
+
+#if !defined(SIMD_SSE2)
+    #if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+        #define SIMD_SSE2 1
+    #else
+        #define SIMD_SSE2 0
+    #endif
 #endif
 
 #endif // BASE_CTX_CRACK_H
@@ -236,6 +259,12 @@ static const int __arch_endian_check_num = 1;
 #include <string.h>
 #include <stdio.h>
 
+#if SIMD_AVX2
+#include <immintrin.h>
+#elif SIMD_SSE2
+#include <emmintrin.h>
+#endif
+
 //
 // Keywords
 //
@@ -855,6 +884,32 @@ enum
     MatchFlag_FindLast         = 1 << 3,
 };
 
+// NOTE(nick): a small set of bytes to scan for, e.g. the characters that start markup in a parser
+#define CHAR_SET_MAX_COUNT 16
+
+#if SIMD_AVX2
+    #define CHAR_SET_BLOCK_SIZE 32
+#else
+    #define CHAR_SET_BLOCK_SIZE 16
+#endif
+
+typedef struct Char_Set Char_Set;
+struct Char_Set
+{
+    u8 chars[CHAR_SET_MAX_COUNT];
+    u32 count;
+    b8 table[256];
+};
+
+// NOTE(nick): walks the pieces of a string between separators without allocating
+typedef struct String_Split String_Split;
+struct String_Split
+{
+    String text;
+    String split;
+    i64 index; // start of the next piece, past text.count when done
+};
+
 typedef struct String_Time_Options String_Time_Options;
 struct String_Time_Options
 {
@@ -917,6 +972,17 @@ function i64 string_last_index(String str, String search);
 function b32 string_contains(String str, String search);
 function b32 string_in_bounds(String str, i64 at);
 
+// Char Sets
+function Char_Set char_set_make(String chars);
+function b32 char_set_contains(Char_Set *set, u8 c);
+function u32 char_set_block_mask(Char_Set *set, u8 *at);
+function i64 string_find_char_set(String str, Char_Set *set, i64 start_index);
+
+// Splitting
+function String_Split string_split_begin(String text, String split);
+function String_Split string_lines_begin(String text);
+function b32 string_split_next(String_Split *iter, String *piece);
+
 // Allocation
 function String string_copy(Arena *arena, String str);
 function String string_alloc(String str);
@@ -1186,6 +1252,12 @@ struct File_Lister
     u8 opaque[1024];
 };
 
+typedef struct File_Watcher File_Watcher;
+struct File_Watcher
+{
+    u8 opaque[1024];
+};
+
 typedef struct OS_Library OS_Library;
 struct OS_Library {
     void *handle;
@@ -1286,6 +1358,11 @@ function File_Lister *os_file_iter_begin(Arena *arena, String path);
 function bool os_file_iter_next(Arena *arena, File_Lister *iter, File_Info *info);
 function void os_file_iter_end(File_Lister *iter);
 
+// File Watcher
+function File_Watcher *os_file_watcher_begin(Arena *arena, String path);
+function bool os_file_watcher_wait(Arena *arena, File_Watcher *watcher, String_List *changed_paths, i64 timeout_ms);
+function void os_file_watcher_end(File_Watcher *watcher);
+
 // Clipboard
 function String os_get_clipboard_text();
 function bool os_set_clipboard_text(String str);
@@ -1418,6 +1495,7 @@ struct Worker_Params
 
 function void work_queue_init(Work_Queue *queue, u64 thread_count);
 function void work_queue_add_entry(Work_Queue *queue, Worker_Proc *callback, void *data);
+function void work_queue_complete_all_work(Work_Queue *queue);
 
 //
 // Platform-Specific Headers:
@@ -1438,6 +1516,7 @@ function void work_queue_add_entry(Work_Queue *queue, Worker_Proc *callback, voi
 #pragma pop_macro("function")
 #pragma pop_macro("Free")
 #elif OS_MACOS
+#elif OS_LINUX
 #else
     #error OS layer not implemented.
 #endif
@@ -2332,6 +2411,105 @@ function b32 string_in_bounds(String str, i64 at) {
     return at < str.count;
 }
 
+//
+// Char Sets
+//
+
+function u32 count_trailing_zeros_u32(u32 x)
+{
+    assert(x != 0);
+
+    #if COMPILER_MSVC
+    unsigned long result;
+    _BitScanForward(&result, x);
+    return (u32)result;
+    #else
+    return (u32)__builtin_ctz(x);
+    #endif
+}
+
+function Char_Set char_set_make(String chars)
+{
+    Char_Set result = {0};
+
+    assert(chars.count <= CHAR_SET_MAX_COUNT);
+
+    for (i64 i = 0; i < chars.count && i < CHAR_SET_MAX_COUNT; i += 1)
+    {
+        u8 c = chars.data[i];
+        if (!result.table[c])
+        {
+            result.table[c] = true;
+            result.chars[result.count] = c;
+            result.count += 1;
+        }
+    }
+
+    return result;
+}
+
+function b32 char_set_contains(Char_Set *set, u8 c)
+{
+    return set->table[c];
+}
+
+// NOTE(nick): returns a bitmask where bit i is set if at[i] is in the set, for CHAR_SET_BLOCK_SIZE bytes
+// The caller has to make sure that many bytes are readable.
+function u32 char_set_block_mask(Char_Set *set, u8 *at)
+{
+    u32 result = 0;
+
+    #if SIMD_AVX2
+    __m256i block = _mm256_loadu_si256((__m256i *)at);
+    __m256i match = _mm256_setzero_si256();
+    for (u32 i = 0; i < set->count; i += 1)
+    {
+        match = _mm256_or_si256(match, _mm256_cmpeq_epi8(block, _mm256_set1_epi8((char)set->chars[i])));
+    }
+    result = (u32)_mm256_movemask_epi8(match);
+    #elif SIMD_SSE2
+    __m128i block = _mm_loadu_si128((__m128i *)at);
+    __m128i match = _mm_setzero_si128();
+    for (u32 i = 0; i < set->count; i += 1)
+    {
+        match = _mm_or_si128(match, _mm_cmpeq_epi8(block, _mm_set1_epi8((char)set->chars[i])));
+    }
+    result = (u32)_mm_movemask_epi8(match);
+    #else
+    for (u32 i = 0; i < CHAR_SET_BLOCK_SIZE; i += 1)
+    {
+        result |= (u32)set->table[at[i]] << i;
+    }
+    #endif
+
+    return result;
+}
+
+// NOTE(nick): returns the index of the first byte at or after start_index that is in the set, or str.count
+function i64 string_find_char_set(String str, Char_Set *set, i64 start_index)
+{
+    i64 i = Max(start_index, 0);
+
+    while (i + CHAR_SET_BLOCK_SIZE <= str.count)
+    {
+        u32 mask = char_set_block_mask(set, str.data + i);
+        if (mask)
+        {
+            return i + count_trailing_zeros_u32(mask);
+        }
+
+        i += CHAR_SET_BLOCK_SIZE;
+    }
+
+    while (i < str.count)
+    {
+        if (set->table[str.data[i]]) return i;
+        i += 1;
+    }
+
+    return str.count;
+}
+
 function String string_split_iter(String text, String search, i64 *index)
 {
     i64 next_index = *index+1;
@@ -2347,6 +2525,52 @@ function String string_split_iter(String text, String search, i64 *index)
     return result;
 }
 
+function String_Split string_split_begin(String text, String split)
+{
+    String_Split result = {0};
+    result.text  = text;
+    result.split = split;
+    return result;
+}
+
+function String_Split string_lines_begin(String text)
+{
+    return string_split_begin(text, S("\n"));
+}
+
+// NOTE(nick): yields every piece, including empty ones between back-to-back separators and after a
+// trailing one, so "a,,b," gives "a", "", "b" and ""
+function b32 string_split_next(String_Split *iter, String *piece)
+{
+    String text  = iter->text;
+    String split = iter->split;
+    if (iter->index > text.count) return false;
+
+    i64 end = text.count;
+    if (split.count > 0)
+    {
+        i64 last_start = text.count - split.count;
+        i64 i = iter->index;
+        while (i <= last_start)
+        {
+            u8 *at = (u8 *)memchr(text.data + i, split.data[0], last_start - i + 1);
+            if (!at) break;
+
+            i = at - text.data;
+            if (MemoryEquals(at, split.data, split.count))
+            {
+                end = i;
+                break;
+            }
+            i += 1;
+        }
+    }
+
+    *piece = string_slice(text, iter->index, end);
+    iter->index = end < text.count ? end + split.count : text.count + 1;
+    return true;
+}
+
 
 //
 // Allocation
@@ -2439,60 +2663,44 @@ function String string_print(Arena *arena, __FormatString const char *fmt, ...)
     return result;
 }
 
+// NOTE(nick): matches don't overlap, a replace_limit of 0 replaces all of them
 function String string_replace(Arena *arena, String str, String find, String replacer, u64 replace_limit)
 {
     String result = str;
     if (replace_limit == 0) replace_limit = U64_MAX;
+    if (find.count == 0) return result;
 
+    // NOTE(nick): every piece but the last one is followed by a match
     u64 match_count = 0;
-    u64 replace_count = replace_limit;
-    if (replace_count > 0 && find.count > 0)
+    String piece = {0};
+    String_Split parts = string_split_begin(str, find);
+    while (match_count < replace_limit && string_split_next(&parts, &piece))
     {
-        i64 index = -1;
-        while (index < str.count)
-        {
-            index = string_find(str, find, index + 1, 0);
-            if (index < str.count)
-            {
-                replace_count -= 1;
-                if (replace_count == 0) break;
-
-                match_count += 1;
-            }
-        }
+        if (parts.index <= str.count) match_count += 1;
     }
 
     if (match_count > 0)
     {
-        u64 count = str.count - (replacer.count - find.count) * match_count;
+        u64 count = str.count + match_count * replacer.count - match_count * find.count;
         u8 *data = PushArray(arena, u8, count);
         u8 *at = data;
 
-        i64 index = -1;
-        while (index < str.count)
+        parts = string_split_begin(str, find);
+        for (u64 i = 0; i < match_count; i += 1)
         {
-            i64 start_index = Max(index, 0);
-            index = string_find(str, find, index, 0);
+            string_split_next(&parts, &piece);
 
-            MemoryCopy(at, str.data + start_index, (index - start_index));
-            at += (index - start_index);
-
-            if (index < str.count)
-            {
-                MemoryCopy(at, replacer.data, replacer.count);
-                at += replacer.count;
-                index += find.count;
+            MemoryCopy(at, piece.data, piece.count);
+            at += piece.count;
 
-                if (match_count == 0)
-                {
-                    MemoryCopy(at, str.data + index, str.count - index);
-                    at += str.count - index;
-                    break;
-                }
-                match_count -= 1;
-            }
+            MemoryCopy(at, replacer.data, replacer.count);
+            at += replacer.count;
         }
 
+        String rest = string_slice(str, parts.index, str.count);
+        MemoryCopy(at, rest.data, rest.count);
+        at += rest.count;
+
         result = Str8(data, at - data);
     }
 
@@ -3411,28 +3619,27 @@ function String path_extension(String path)
 {
     String result = {0};
     i64 slash_pos = string_find(path, S("/"), 0, MatchFlag_SlashInsensitive|MatchFlag_FindLast);
-    if (slash_pos < path.count)
+    // NOTE(nick): a path without a directory, e.g. "index.html"
+    if (slash_pos >= path.count) slash_pos = 0;
+
+    i64 dot_pos = string_find(path, S("."), slash_pos, MatchFlag_FindLast);
+    if (dot_pos < path.count)
     {
-        i64 dot_pos = string_find(path, S("."), slash_pos, MatchFlag_FindLast);
-        if (dot_pos < path.count)
-        {
-            result = string_slice(path, dot_pos, path.count);
-        }
+        result = string_slice(path, dot_pos, path.count);
     }
     return result;
 }
 
 function String path_strip_extension(String path)
 {
-    String result = {0};
+    String result = path;
     i64 slash_pos = string_find(path, S("/"), 0, MatchFlag_SlashInsensitive|MatchFlag_FindLast);
-    if (slash_pos < path.count)
+    if (slash_pos >= path.count) slash_pos = 0;
+
+    i64 dot_pos = string_find(path, S("."), slash_pos, MatchFlag_FindLast);
+    if (dot_pos < path.count)
     {
-        i64 dot_pos = string_find(path, S("."), slash_pos, MatchFlag_FindLast);
-        if (dot_pos < path.count)
-        {
-            result = string_slice(path, 0, dot_pos);
-        }
+        result = string_slice(path, 0, dot_pos);
     }
     return result;
 }
@@ -3697,7 +3904,6 @@ function u64 murmur64_seed(void const *data_, i64 len, u64 seed) {
     u64 h = seed ^ (len * m);
 
     u64 const *data = cast(u64 const *)data_;
-    u8  const *data2 = cast(u8 const *)data_;
     u64 const* end = data + (len / 8);
 
     while (data != end) {
@@ -3711,6 +3917,9 @@ function u64 murmur64_seed(void const *data_, i64 len, u64 seed) {
         h *= m;
     }
 
+    // NOTE(nick): the tail is whatever is left after the 8 byte blocks
+    u8 const *data2 = cast(u8 const *)data;
+
     switch (len & 7) {
     case 7: h ^= cast(u64)(data2[6]) << 48;
     case 6: h ^= cast(u64)(data2[5]) << 40;
@@ -4969,7 +5178,7 @@ function Thread thread_create(Thread_Proc *proc, void *data, u64 copy_size) {
     params->data = data;
     if (copy_size)
     {
-        params->data = params + sizeof(Win32_Thread_Params);
+        params->data = (u8 *)params + sizeof(Win32_Thread_Params);
         MemoryCopy(params->data, data, copy_size);
     }
 
@@ -5409,107 +5618,369 @@ function void mutex_destroy(Mutex *mutex) {
     mutex->handle = 0;
 }
 #elif OS_LINUX
-    #error Not implemented
-#endif
-
-#if OS_WINDOWS || OS_MACOS
-    #include <stdlib.h>
-#include <dirent.h>
-#include <sys/stat.h>
+    #include <time.h>
+#include <unistd.h>
+#include <errno.h>
 
-#include <stdio.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdlib.h>
 
-#include <sys/mman.h>
+#ifndef PATH_MAX
+#define PATH_MAX 4096
+#endif
 
-typedef struct Unix_File_Lister Unix_File_Lister;
-struct Unix_File_Lister {
-    char *find_path;
-    DIR *handle;
-};
+static pthread_key_t linux_thread_local_key;
 
 //
-// Timing
+// System
 //
 
-function void os_set_high_process_priority(bool enable) {
-    if (enable) {
-        setpriority(PRIO_PROCESS, getpid(), -20);
-    } else {
-        setpriority(PRIO_PROCESS, getpid(), 0);
-    }
-}
+function bool os_init() {
+    // NOTE(nick): calling these functions initializes their state
+    GetScratch(0, 0);
+    os_time();
 
-//
-// Memory
-//
+    pthread_key_create(&linux_thread_local_key, NULL);
 
-function u64 os_memory_page_size() {
-    i64 result = sysconf(_SC_PAGE_SIZE);
-    return (u64)result;
+    return true;
 }
 
-function void *os_memory_reserve(u64 size) {
-    void *result = 0;
+function void os_exit(i32 code)
+{
+    exit(code);
+}
 
-    result = mmap(NULL, size, PROT_NONE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
-    if (result  == (void*)-1)
-    {
-        result = 0;
-    }
+function String os_get_system_path(Arena *arena, SystemPath path)
+{
+    String result = {0};
 
-    return result;
-}
+    switch (path)
+    {
+        case SystemPath_Current:
+        {
+            char *buffer = (char *)arena_push(arena, PATH_MAX);
+            getcwd(buffer, PATH_MAX);
 
-function bool os_memory_commit(void *ptr, u64 size) {
-    u64 page_size = os_memory_page_size();
+            result = string_from_cstr(buffer);
+            i64 unused_size = PATH_MAX - result.count;
+            arena_pop(arena, unused_size);
+        } break;
 
-    i64 p = (i64)ptr;
-    i64 p_aligned = AlignDownPow2(p, page_size);
+        case SystemPath_Binary:
+        {
+            char *buffer = (char *)arena_push(arena, PATH_MAX);
 
-    if (p != p_aligned) {
-        i64 delta = p - p_aligned;
-        ptr = (void *)((u8 *)ptr - delta);
-        size += delta;
-    }
+            // NOTE(nick): readlink doesn't null-terminate, and the link is already an absolute path
+            ssize_t length = readlink("/proc/self/exe", buffer, PATH_MAX);
+            if (length > 0)
+            {
+                result = Str8(buffer, length);
+                i64 unused_size = PATH_MAX - result.count;
+                arena_pop(arena, unused_size);
 
-    size = AlignUpPow2(size, page_size);
+                result = string_chop_last_slash(result);
+            }
+            else
+            {
+                arena_pop(arena, PATH_MAX);
+            }
+        } break;
 
-    // printf("[commit] %p (%lld)\n", ptr, size);
+        case SystemPath_AppData:
+        {
+            char *data_home = getenv("XDG_DATA_HOME");
+            if (data_home && data_home[0])
+            {
+                result = string_concat2(arena, string_from_cstr(data_home), S("/"));
+            }
+            else
+            {
+                String home = string_from_cstr(getenv("HOME"));
+                result = string_concat2(arena, home, S("/.local/share/"));
+            }
+        } break;
+    }
 
-    // NOTE(nick): ptr must be aligned to a page boundary.
-    int result = mprotect(ptr, size, PROT_READ | PROT_WRITE);
-    madvise(ptr, size, MADV_WILLNEED);
-    return result == 0;
+    return result;
 }
 
-function bool os_memory_decommit(void *ptr, u64 size) {
-    u64 page_size = os_memory_page_size();
+//
+// Timing
+//
 
-    i64 p = (i64)ptr;
-    i64 p_aligned = AlignDownPow2(p, page_size);
+function f64 os_time()
+{
+    static u64 linux_initial_clock = 0;
 
-    if (p != p_aligned) {
-        i64 delta = p - p_aligned;
-        ptr = (void *)((u8 *)ptr - delta);
-        size += delta;
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &now);
+
+    u64 nanoseconds = (u64)now.tv_sec * 1000000000ull + (u64)now.tv_nsec;
+    if (!linux_initial_clock)
+    {
+        linux_initial_clock = nanoseconds;
     }
 
-    size = AlignUpPow2(size, page_size);
+    return (f64)(nanoseconds - linux_initial_clock) / (f64)(1e9);
+}
 
-    // printf("[decommit] %p (%lld)\n", ptr, size);
+function void os_sleep(f64 seconds)
+{
+    u64 nanoseconds = (u64)((seconds) * (1e9));
 
-    // NOTE(nick): ptr must be aligned to a page boundary.
-    // int result = mprotect(ptr, size, PROT_NONE);
-    madvise(ptr, size, MADV_DONTNEED);
-    // return result == 0;
-    return true;
-}
+    struct timespec rqtp;
+    rqtp.tv_sec = nanoseconds / 1000000000;
+    rqtp.tv_nsec = nanoseconds - rqtp.tv_sec * 1000000000;
 
-function bool os_memory_release(void *ptr, u64 size) {
-    return munmap(ptr, size) == 0;
+    // NOTE(nick): signals wake us up early, keep sleeping for whatever is left
+    while (nanosleep(&rqtp, &rqtp) == -1 && errno == EINTR) {}
 }
 
-function void *os_alloc(u64 size) {
+//
+// Clipboard
+//
+
+// @Incomplete: there's no clipboard without talking to X11 or Wayland
+function String os_get_clipboard_text()
+{
+    String result = {0};
+    return result;
+}
+
+function bool os_set_clipboard_text(String text)
+{
+    return false;
+}
+
+//
+// Library
+//
+
+#include <dlfcn.h>
+
+function OS_Library os_library_load(String path) {
+    M_Temp scratch = GetScratch(0, 0);
+
+    OS_Library result = {0};
+    result.handle = dlopen(string_to_cstr(scratch.arena, path), RTLD_LAZY | RTLD_GLOBAL);
+
+    ReleaseScratch(scratch);
+    return result;
+}
+
+function void os_library_unload(OS_Library lib) {
+    if (lib.handle) {
+        dlclose(lib.handle);
+        lib.handle = 0;
+    }
+}
+
+function void *os_library_get_proc(OS_Library lib, char *proc_name) {
+    return (void *)dlsym(lib.handle, proc_name);
+}
+
+//
+// Shell
+//
+
+function bool os_shell_open(String path)
+{
+    M_Temp scratch = GetScratch(0, 0);
+    char *str = string_to_cstr(scratch.arena, path);
+
+    bool result = false;
+
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        execlp("xdg-open", "xdg-open", str, (char *)NULL);
+        _exit(127);
+    }
+
+    result = pid > 0;
+
+    ReleaseScratch(scratch);
+    return result;
+}
+
+//
+// Threading Primitives
+//
+
+function Semaphore semaphore_create(u32 max_count) {
+    Semaphore result = {0};
+
+    sem_t *handle = cast(sem_t *)os_alloc(sizeof(sem_t)); // @Memory @Cleanup
+    result.handle = handle;
+
+    // NOTE(nick): starts at zero like the Win32 version, POSIX semaphores have no max_count
+    int ret = sem_init(handle, 0, 0);
+    assert(ret == 0);
+
+    return result;
+}
+
+function void semaphore_signal(Semaphore *sem) {
+    int ret = sem_post(cast(sem_t *)sem->handle);
+    assert(ret == 0);
+}
+
+function void semaphore_wait_for(Semaphore *sem, bool infinite) {
+    auto handle = cast(sem_t *)sem->handle;
+
+    if (infinite) {
+        while (sem_wait(handle) == -1 && errno == EINTR) {}
+    } else {
+        // NOTE(nick): same 50ms as the Win32 version
+        struct timespec until;
+        clock_gettime(CLOCK_REALTIME, &until);
+        until.tv_nsec += 50 * 1000000;
+        if (until.tv_nsec >= 1000000000) {
+            until.tv_sec  += 1;
+            until.tv_nsec -= 1000000000;
+        }
+
+        while (sem_timedwait(handle, &until) == -1 && errno == EINTR) {}
+    }
+}
+
+function void semaphore_destroy(Semaphore *sem) {
+    auto handle = cast(sem_t *)sem->handle;
+    sem_destroy(handle);
+    os_free(handle); // @Memory @Cleanup
+    sem->handle = 0;
+}
+
+function Mutex mutex_create(u32 spin_count) {
+    Mutex result = {0};
+
+    result.handle = os_alloc(sizeof(pthread_mutex_t));
+    pthread_mutex_init(cast(pthread_mutex_t *)result.handle, NULL);
+
+    // @Incomplete: should spin_count do anything?
+
+    return result;
+}
+
+function void mutex_aquire_lock(Mutex *mutex) {
+    pthread_mutex_lock(cast(pthread_mutex_t *)mutex->handle);
+}
+
+function bool mutex_try_aquire_lock(Mutex *mutex) {
+    return pthread_mutex_trylock(cast(pthread_mutex_t *)mutex->handle) == 0;
+}
+
+function void mutex_release_lock(Mutex *mutex) {
+    pthread_mutex_unlock(cast(pthread_mutex_t *)mutex->handle);
+}
+
+function void mutex_destroy(Mutex *mutex) {
+    pthread_mutex_destroy(cast(pthread_mutex_t *)mutex->handle);
+    os_free(mutex->handle);
+    mutex->handle = 0;
+}
+#endif
+
+#if OS_MACOS || OS_LINUX
+    #include <stdlib.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/resource.h> // setpriority
+
+#include <stdio.h>
+
+#include <sys/mman.h>
+
+typedef struct Unix_File_Lister Unix_File_Lister;
+struct Unix_File_Lister {
+    char *find_path;
+    DIR *handle;
+};
+
+//
+// Timing
+//
+
+function void os_set_high_process_priority(bool enable) {
+    if (enable) {
+        setpriority(PRIO_PROCESS, getpid(), -20);
+    } else {
+        setpriority(PRIO_PROCESS, getpid(), 0);
+    }
+}
+
+//
+// Memory
+//
+
+function u64 os_memory_page_size() {
+    i64 result = sysconf(_SC_PAGE_SIZE);
+    return (u64)result;
+}
+
+function void *os_memory_reserve(u64 size) {
+    void *result = 0;
+
+    result = mmap(NULL, size, PROT_NONE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+    if (result  == (void*)-1)
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+function bool os_memory_commit(void *ptr, u64 size) {
+    u64 page_size = os_memory_page_size();
+
+    i64 p = (i64)ptr;
+    i64 p_aligned = AlignDownPow2(p, page_size);
+
+    if (p != p_aligned) {
+        i64 delta = p - p_aligned;
+        ptr = (void *)((u8 *)ptr - delta);
+        size += delta;
+    }
+
+    size = AlignUpPow2(size, page_size);
+
+    // printf("[commit] %p (%lld)\n", ptr, size);
+
+    // NOTE(nick): ptr must be aligned to a page boundary.
+    int result = mprotect(ptr, size, PROT_READ | PROT_WRITE);
+    madvise(ptr, size, MADV_WILLNEED);
+    return result == 0;
+}
+
+function bool os_memory_decommit(void *ptr, u64 size) {
+    u64 page_size = os_memory_page_size();
+
+    i64 p = (i64)ptr;
+    i64 p_aligned = AlignDownPow2(p, page_size);
+
+    if (p != p_aligned) {
+        i64 delta = p - p_aligned;
+        ptr = (void *)((u8 *)ptr - delta);
+        size += delta;
+    }
+
+    size = AlignUpPow2(size, page_size);
+
+    // printf("[decommit] %p (%lld)\n", ptr, size);
+
+    // NOTE(nick): ptr must be aligned to a page boundary.
+    // int result = mprotect(ptr, size, PROT_NONE);
+    madvise(ptr, size, MADV_DONTNEED);
+    // return result == 0;
+    return true;
+}
+
+function bool os_memory_release(void *ptr, u64 size) {
+    return munmap(ptr, size) == 0;
+}
+
+function void *os_alloc(u64 size) {
     return calloc(size, 1);
 }
 
@@ -5600,7 +6071,7 @@ function File_Info os_get_file_info(String path) {
     return info;
 }
 
-void unix_file_error(File *file, char *message, String file_name) {
+function void unix_file_error(File *file, const char *message, String file_name) {
 #if DEBUG
     if (file_name.data) {
         print("[file] %s: %.*s\n", message, LIT(file_name));
@@ -5730,12 +6201,12 @@ function String os_read_entire_file(Arena *arena, String path) {
         fseek(f, prev_position, SEEK_SET);
     }
 
+    // NOTE(nick): missing files come back with a NULL data pointer, same as on windows
     String result = {0};
-    result.data = cast(u8 *)arena_push(arena, size);
-    result.count = size;
-
     if (!file.has_errors)
     {
+        result.data = cast(u8 *)arena_push(arena, size);
+        result.count = size;
         os_file_read(&file, 0, size, result.data);
     }
     os_file_close(&file);
@@ -5758,17 +6229,13 @@ function bool os_write_entire_file(String path, String contents) {
 //
 
 function File_Lister *os_file_iter_begin(Arena *arena, String path) {
-    M_Temp scratch = GetScratch(&arena, 1);
-
-    char *cpath = string_to_cstr(scratch.arena, path);
+    char *cpath = string_to_cstr(arena, path);
     DIR *handle = opendir(cpath);
 
     Unix_File_Lister *it = PushStructZero(arena, Unix_File_Lister);
     it->find_path = cpath;
     it->handle    = handle;
 
-    ReleaseScratch(scratch);
-
     return (File_Lister *)it;
 }
 
@@ -5783,11 +6250,12 @@ function bool os_file_iter_next(Arena *arena, File_Lister *iter, File_Info *info
 
     if (data != NULL)
     {
-        char buffer[PATH_MAX + 1];
-        if (realpath(data->d_name, buffer) != NULL)
-        {
-            *info = os_get_file_info(string_from_cstr(buffer));
-        }
+        // NOTE(nick): d_name is relative to the directory being listed, not the working directory
+        String name = string_copy(arena, string_from_cstr(data->d_name));
+        String path = string_concat3(arena, string_from_cstr(it->find_path), S("/"), name);
+
+        *info = os_get_file_info(path);
+        info->name = name;
     }
 
     return data != NULL;
@@ -5827,7 +6295,26 @@ function bool os_delete_directory(String path) {
 //
 
 #include <pthread.h>
-#include <sys/resource.h> // setpriority
+
+//
+// Atomics
+//
+
+function u32 atomic_compare_exchange_u32(u32 volatile *value, u32 New, u32 Expected) {
+    u32 result = __sync_val_compare_and_swap(value, Expected, New);
+    return (result);
+}
+
+function u64 atomic_exchange_u64(u64 volatile *value, u64 New) {
+    u64 result = __sync_lock_test_and_set(value, New);
+    return (result);
+}
+
+function u64 atomic_add_u64(u64 volatile *value, u64 Addend) {
+    // NOTE(nick): Returns the original value _prior_ to adding (same as the Win32 version)
+    u64 result = __sync_fetch_and_add(value, Addend);
+    return (result);
+}
 
 typedef struct Unix_Thread_Params Unix_Thread_Params;
 struct Unix_Thread_Params {
@@ -5846,7 +6333,7 @@ void *unix_thread_proc(void *data) {
 
     os_free(params);
 
-    return (void *)result;
+    return (void *)(u64)result;
 }
 
 function Thread thread_create(Thread_Proc *proc, void *data, u64 copy_size) {
@@ -5855,7 +6342,7 @@ function Thread thread_create(Thread_Proc *proc, void *data, u64 copy_size) {
     params->data = data;
     if (copy_size)
     {
-        params->data = params + sizeof(Unix_Thread_Params);
+        params->data = (u8 *)params + sizeof(Unix_Thread_Params);
         MemoryCopy(params->data, data, copy_size);
     }
 
@@ -5879,6 +6366,62 @@ function u32 thread_await(Thread thread) {
     return *(u32 *)result;
 }
 
+//
+// Dates
+//
+
+function Date_Time unix_date_time_from_tm(struct tm *in, u16 msec) {
+    Date_Time result = {0};
+
+    result.year = (i16)(in->tm_year + 1900);
+    result.mon  = (u8)(in->tm_mon + 1);
+    result.day  = (u8)in->tm_mday;
+    result.hour = (u8)in->tm_hour;
+    result.min  = (u8)in->tm_min;
+    result.sec  = (u8)in->tm_sec;
+    result.msec = msec;
+
+    return result;
+}
+
+function Date_Time os_get_current_time_in_utc() {
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    struct tm tm;
+    gmtime_r(&now.tv_sec, &tm);
+    return unix_date_time_from_tm(&tm, (u16)(now.tv_nsec / 1000000));
+}
+
+function Date_Time os_get_local_time() {
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    struct tm tm;
+    localtime_r(&now.tv_sec, &tm);
+    return unix_date_time_from_tm(&tm, (u16)(now.tv_nsec / 1000000));
+}
+
+//
+// Shell
+//
+
+function bool os_shell_execute(String cmd, String arguments, bool admin) {
+    // @Incomplete: admin
+    M_Temp scratch = GetScratch(0, 0);
+    char *command = string_to_cstr(scratch.arena, string_concat3(scratch.arena, cmd, S(" "), arguments));
+
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        execl("/bin/sh", "sh", "-c", command, (char *)NULL);
+        _exit(127);
+    }
+
+    ReleaseScratch(scratch);
+    return pid > 0;
+}
+
 #endif
 
 //
@@ -5892,7 +6435,7 @@ function f64 os_time_in_miliseconds()
 
 force_inline function u64 os_clock_cycles(void)
 {
-    #if defined(COMPILER_MSVC) && !defined(__clang__)
+    #if COMPILER_MSVC && !defined(__clang__)
         return __rdtsc();
     #elif defined(__i386__)
         u64 x;
@@ -6146,6 +6689,17 @@ function void work_queue_add_entry(Work_Queue *queue, Worker_Proc *callback, voi
     semaphore_signal(&queue->semaphore);
 }
 
+// NOTE(nick): the calling thread helps out until every entry added so far is done
+function void work_queue_complete_all_work(Work_Queue *queue)
+{
+    while (queue->completion_goal != queue->completion_count) {
+        os__do_next_work_queue_entry(queue);
+    }
+
+    queue->completion_goal = 0;
+    queue->completion_count = 0;
+}
+
 
 //
 // Array macros for partial functionality:
@@ -6638,6 +7192,9 @@ function void table_rehash(Table_KV *it, u64 next_capacity)
     it->keys  = (u8 *)it->slots + sizeof(H_Slot) * it->capacity;
     it->data  = (u8 *)it->keys  + it->capacity * it->key_size;
 
+    // NOTE(nick): this arena held the table from two resizes ago, so the old slots are still in it
+    MemoryZero(it->slots, sizeof(H_Slot) * it->capacity);
+
     for (u64 index = 0; index < old_capacity; index++) {
         H_Slot *entry = &old_slots[index];
 
@@ -6807,4 +7364,414 @@ function b32 table_delete(Table_KV *it, i64 index)
     return result;
 }
 
+//
+// File Watcher
+//
+// Reports the paths (relative to the watched directory) of files that were
+// created, modified, moved or deleted anywhere under it. An empty path means
+// events were lost, and anything under the directory might have changed.
+//
+
+#if OS_LINUX
+
+#include <sys/inotify.h>
+#include <poll.h>
+#include <dirent.h>
+#include <unistd.h>
+
+typedef struct Linux_File_Watcher Linux_File_Watcher;
+struct Linux_File_Watcher
+{
+    int fd;
+    Arena *arena;
+    String root;
+
+    // NOTE(nick): watch descriptor -> directory path relative to root
+    // (descriptors keep counting up as directories come and go, so they can't index an array)
+    Table_KV directories;
+};
+
+function String *linux_file_watcher_directory(Linux_File_Watcher *watcher, int wd)
+{
+    i64 key = wd;
+    return (String *)table_get(&watcher->directories, table_hash_i64(key), &key);
+}
+
+// NOTE(nick): when changed_paths is set, every file under the directory is pushed to it
+// (a directory that was just created or moved in doesn't get events for what was already in it)
+function void linux_file_watcher_add(Linux_File_Watcher *watcher, String relative_path, Arena *arena, String_List *changed_paths)
+{
+    Arena *conflicts[] = {watcher->arena, arena};
+    M_Temp scratch = GetScratch(conflicts, count_of(conflicts));
+
+    String path = relative_path.count ? path_join2(scratch.arena, watcher->root, relative_path) : watcher->root;
+    char *cpath = string_to_cstr(scratch.arena, path);
+
+    u32 mask = IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO;
+    int wd = inotify_add_watch(watcher->fd, cpath, mask);
+    if (wd >= 0)
+    {
+        i64 key = wd;
+        String directory = string_copy(watcher->arena, relative_path);
+        table_set(&watcher->directories, table_hash_i64(key), &key, &directory);
+    }
+
+    // NOTE(nick): inotify isn't recursive, every sub-directory needs its own watch
+    DIR *handle = opendir(cpath);
+    if (handle)
+    {
+        struct dirent *data;
+        while ((data = readdir(handle)) != NULL)
+        {
+            String name = string_from_cstr(data->d_name);
+            if (string_equals(name, S(".")) || string_equals(name, S(".."))) continue;
+
+            String child = relative_path.count ? path_join2(scratch.arena, relative_path, name) : name;
+
+            if (data->d_type == DT_DIR)
+            {
+                linux_file_watcher_add(watcher, child, arena, changed_paths);
+            }
+            else if (changed_paths)
+            {
+                string_list_push(arena, changed_paths, string_copy(arena, child));
+            }
+        }
+        closedir(handle);
+    }
+
+    ReleaseScratch(scratch);
+}
+
+function File_Watcher *os_file_watcher_begin(Arena *arena, String path)
+{
+    Linux_File_Watcher *watcher = PushStructZero(arena, Linux_File_Watcher);
+    watcher->fd    = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    watcher->arena = arena;
+    watcher->root  = string_copy(arena, path);
+    table_init(&watcher->directories, sizeof(i64), sizeof(String));
+
+    if (watcher->fd >= 0)
+    {
+        linux_file_watcher_add(watcher, S(""), NULL, NULL);
+    }
+
+    return (File_Watcher *)watcher;
+}
+
+function bool os_file_watcher_wait(Arena *arena, File_Watcher *it, String_List *changed_paths, i64 timeout_ms)
+{
+    Linux_File_Watcher *watcher = (Linux_File_Watcher *)it;
+    if (watcher->fd < 0) return false;
+
+    struct pollfd pfd = {0};
+    pfd.fd     = watcher->fd;
+    pfd.events = POLLIN;
+
+    if (poll(&pfd, 1, (int)timeout_ms) <= 0) return false;
+
+    // NOTE(nick): saving a file usually shows up as a burst of events (write, rename, etc.)
+    // so drain everything that is queued up before returning
+    u64 buffer[512];
+    for (;;)
+    {
+        ssize_t length = read(watcher->fd, buffer, sizeof(buffer));
+        if (length <= 0) break;
+
+        u8 *at  = (u8 *)buffer;
+        u8 *end = at + length;
+        while (at < end)
+        {
+            struct inotify_event *event = (struct inotify_event *)at;
+            at += sizeof(struct inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW)
+            {
+                string_list_push(arena, changed_paths, S(""));
+                continue;
+            }
+
+            // NOTE(nick): the directory was deleted (or moved out), its descriptor won't be used again
+            if (event->mask & IN_IGNORED)
+            {
+                i64 key = event->wd;
+                table_remove(&watcher->directories, table_hash_i64(key), &key);
+                continue;
+            }
+
+            if (!event->len) continue;
+
+            String *directory = linux_file_watcher_directory(watcher, event->wd);
+            if (!directory) continue;
+
+            String name = string_from_cstr(event->name);
+            String path = directory->count ? path_join2(arena, *directory, name) : string_copy(arena, name);
+
+            if ((event->mask & IN_ISDIR) && (event->mask & (IN_CREATE | IN_MOVED_TO)))
+            {
+                linux_file_watcher_add(watcher, path, arena, changed_paths);
+                continue;
+            }
+
+            if (changed_paths->last && string_equals(changed_paths->last->string, path)) continue;
+            string_list_push(arena, changed_paths, path);
+        }
+    }
+
+    return changed_paths->node_count > 0;
+}
+
+function void os_file_watcher_end(File_Watcher *it)
+{
+    Linux_File_Watcher *watcher = (Linux_File_Watcher *)it;
+    if (watcher->fd >= 0)
+    {
+        close(watcher->fd);
+        watcher->fd = -1;
+    }
+
+    table_free(&watcher->directories);
+}
+
+#elif OS_MACOS
+
+#include <CoreServices/CoreServices.h>
+#include <dispatch/dispatch.h>
+
+// NOTE(nick): FSEvents calls back on its own dispatch queue, the paths it reports are kept here
+// until os_file_watcher_wait hands them out. This needs -framework CoreServices.
+
+typedef struct Mac_File_Watcher Mac_File_Watcher;
+struct Mac_File_Watcher
+{
+    Arena *arena;
+    String root; // with symlinks resolved, that's how FSEvents reports paths (e.g. /private/tmp)
+
+    FSEventStreamRef stream;
+    dispatch_queue_t queue;
+    dispatch_semaphore_t signal;
+
+    Mutex mutex;
+    Arena *pending_arena;
+    String_List pending;
+};
+
+function void mac_file_watcher_callback(ConstFSEventStreamRef stream, void *info, size_t count, void *event_paths, const FSEventStreamEventFlags *flags, const FSEventStreamEventId *ids)
+{
+    Mac_File_Watcher *watcher = (Mac_File_Watcher *)info;
+    char **paths = (char **)event_paths;
+
+    mutex_aquire_lock(&watcher->mutex);
+
+    for (size_t i = 0; i < count; i += 1)
+    {
+        String path = string_from_cstr(paths[i]);
+        if (path.count <= watcher->root.count || !string_starts_with(path, watcher->root)) continue;
+
+        String relative = string_slice(path, watcher->root.count + 1, path.count);
+        if (watcher->pending.last && string_equals(watcher->pending.last->string, relative)) continue;
+
+        string_list_push(watcher->pending_arena, &watcher->pending, string_copy(watcher->pending_arena, relative));
+    }
+
+    mutex_release_lock(&watcher->mutex);
+
+    dispatch_semaphore_signal(watcher->signal);
+}
+
+function File_Watcher *os_file_watcher_begin(Arena *arena, String path)
+{
+    Mac_File_Watcher *watcher = PushStructZero(arena, Mac_File_Watcher);
+    watcher->arena         = arena;
+    watcher->mutex         = mutex_create(0);
+    watcher->pending_arena = arena_alloc(Megabytes(64));
+    watcher->signal        = dispatch_semaphore_create(0);
+    watcher->queue         = dispatch_queue_create("na.file_watcher", DISPATCH_QUEUE_SERIAL);
+
+    M_Temp scratch = GetScratch(&arena, 1);
+
+    char *cpath = string_to_cstr(scratch.arena, path);
+    char resolved[PATH_MAX];
+    watcher->root = string_copy(arena, string_from_cstr(realpath(cpath, resolved) ? resolved : cpath));
+
+    CFStringRef root = CFStringCreateWithCString(NULL, cpath, kCFStringEncodingUTF8);
+    CFArrayRef paths = CFArrayCreate(NULL, (const void **)&root, 1, &kCFTypeArrayCallBacks);
+
+    ReleaseScratch(scratch);
+
+    FSEventStreamContext context = {0};
+    context.info = watcher;
+
+    // NOTE(nick): file level events with no latency, otherwise FSEvents coalesces changes per directory
+    // and holds them back for the latency window
+    FSEventStreamCreateFlags flags = kFSEventStreamCreateFlagFileEvents | kFSEventStreamCreateFlagNoDefer;
+    watcher->stream = FSEventStreamCreate(NULL, mac_file_watcher_callback, &context, paths, kFSEventStreamEventIdSinceNow, 0.0, flags);
+
+    CFRelease(paths);
+    CFRelease(root);
+
+    if (watcher->stream)
+    {
+        FSEventStreamSetDispatchQueue(watcher->stream, watcher->queue);
+        FSEventStreamStart(watcher->stream);
+    }
+
+    return (File_Watcher *)watcher;
+}
+
+function bool os_file_watcher_wait(Arena *arena, File_Watcher *it, String_List *changed_paths, i64 timeout_ms)
+{
+    Mac_File_Watcher *watcher = (Mac_File_Watcher *)it;
+    if (!watcher->stream) return false;
+
+    dispatch_time_t timeout = DISPATCH_TIME_FOREVER;
+    if (timeout_ms >= 0) timeout = dispatch_time(DISPATCH_TIME_NOW, timeout_ms * NSEC_PER_MSEC);
+
+    if (dispatch_semaphore_wait(watcher->signal, timeout) != 0) return false;
+
+    // NOTE(nick): a burst of events signals more than once, the extra wake ups just find nothing
+    mutex_aquire_lock(&watcher->mutex);
+
+    for (String_Node *node = watcher->pending.first; node != NULL; node = node->next)
+    {
+        if (changed_paths->last && string_equals(changed_paths->last->string, node->string)) continue;
+        string_list_push(arena, changed_paths, string_copy(arena, node->string));
+    }
+
+    MemoryZero(&watcher->pending, sizeof(watcher->pending));
+    arena_reset(watcher->pending_arena);
+
+    mutex_release_lock(&watcher->mutex);
+
+    return changed_paths->node_count > 0;
+}
+
+function void os_file_watcher_end(File_Watcher *it)
+{
+    Mac_File_Watcher *watcher = (Mac_File_Watcher *)it;
+    if (watcher->stream)
+    {
+        FSEventStreamStop(watcher->stream);
+        FSEventStreamInvalidate(watcher->stream);
+        FSEventStreamRelease(watcher->stream);
+        watcher->stream = NULL;
+    }
+
+    dispatch_release(watcher->queue);
+    dispatch_release(watcher->signal);
+
+    mutex_destroy(&watcher->mutex);
+    arena_free(watcher->pending_arena);
+}
+
+#else
+
+// @Incomplete: use ReadDirectoryChangesW instead of polling
+// NOTE(nick): modified times only have second resolution here, so this also compares sizes
+
+typedef struct Poll_File_Entry Poll_File_Entry;
+struct Poll_File_Entry
+{
+    String path;
+    u64 size;
+    Dense_Time updated_at;
+    u64 generation;
+};
+
+typedef struct Poll_File_Watcher Poll_File_Watcher;
+struct Poll_File_Watcher
+{
+    Arena *arena;
+    String root;
+    u64 generation;
+    Table_KV files;
+};
+
+function void poll_file_watcher_scan(Arena *arena, Poll_File_Watcher *watcher, String_List *changed_paths)
+{
+    Arena *conflicts[] = {arena, watcher->arena};
+    M_Temp scratch = GetScratch(conflicts, count_of(conflicts));
+
+    watcher->generation += 1;
+
+    File_List files = os_scan_entire_directory(scratch.arena, watcher->root);
+    for (File_Info *info = files.first; info != NULL; info = info->next)
+    {
+        if (os_file_is_directory(*info)) continue;
+        if (info->path.count <= watcher->root.count) continue;
+
+        String path = string_slice(info->path, watcher->root.count + 1, info->path.count);
+        u64 key = murmur64_from_string(path);
+
+        Poll_File_Entry *entry = (Poll_File_Entry *)table_get(&watcher->files, table_hash_make(key), &key);
+        if (!entry)
+        {
+            Poll_File_Entry it = {0};
+            it.path = string_copy(watcher->arena, path);
+            entry = (Poll_File_Entry *)table_add(&watcher->files, table_hash_make(key), &key, &it);
+
+            if (changed_paths) string_list_push(arena, changed_paths, string_copy(arena, path));
+        }
+        else if (entry->size != info->size || entry->updated_at != info->updated_at)
+        {
+            if (changed_paths) string_list_push(arena, changed_paths, string_copy(arena, path));
+        }
+
+        entry->size       = info->size;
+        entry->updated_at = info->updated_at;
+        entry->generation = watcher->generation;
+    }
+
+    for (i64 index = 0; index < watcher->files.capacity; index += 1)
+    {
+        if (watcher->files.slots[index].hash.value < TABLE_FIRST_VALID_HASH) continue;
+
+        Poll_File_Entry *entry = (Poll_File_Entry *)table_value(&watcher->files, index);
+        if (entry->generation != watcher->generation)
+        {
+            if (changed_paths) string_list_push(arena, changed_paths, string_copy(arena, entry->path));
+            table_delete(&watcher->files, index);
+        }
+    }
+
+    ReleaseScratch(scratch);
+}
+
+function File_Watcher *os_file_watcher_begin(Arena *arena, String path)
+{
+    Poll_File_Watcher *watcher = PushStructZero(arena, Poll_File_Watcher);
+    watcher->arena = arena;
+    watcher->root  = string_copy(arena, path);
+    table_init(&watcher->files, sizeof(u64), sizeof(Poll_File_Entry));
+
+    poll_file_watcher_scan(arena, watcher, NULL);
+
+    return (File_Watcher *)watcher;
+}
+
+function bool os_file_watcher_wait(Arena *arena, File_Watcher *it, String_List *changed_paths, i64 timeout_ms)
+{
+    Poll_File_Watcher *watcher = (Poll_File_Watcher *)it;
+
+    const i64 poll_interval_ms = 50;
+
+    for (i64 waited = 0; ; waited += poll_interval_ms)
+    {
+        poll_file_watcher_scan(arena, watcher, changed_paths);
+
+        if (changed_paths->node_count > 0) return true;
+        if (timeout_ms >= 0 && waited >= timeout_ms) return false;
+
+        os_sleep(poll_interval_ms / 1000.0);
+    }
+}
+
+function void os_file_watcher_end(File_Watcher *it)
+{
+    Poll_File_Watcher *watcher = (Poll_File_Watcher *)it;
+    table_free(&watcher->files);
+}
+
+#endif // OS_LINUX
+
 #endif // NA_H
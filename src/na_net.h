@@ -153,7 +153,7 @@ VERSION HISTORY
 //
 // TODO(nick):
 // - handle chunked responses
-// - replace `select` calls with Linux epoll / win32 / MacOS kqueue solution
+// - replace `select` calls with win32 / MacOS kqueue solution (the Linux server uses epoll)
 //
 
 typedef u32 Socket_Type;
@@ -229,6 +229,22 @@ struct Http_Request
     Socket_Address address;
     String method;
     String url;
+    String version;
+    String headers; // NOTE(nick): the raw header lines after the request line
+    String body;
+
+    bool keep_alive;
+};
+
+#ifndef HTTP_MAX_RANGES
+#define HTTP_MAX_RANGES 16
+#endif
+
+typedef struct Http_Range Http_Range;
+struct Http_Range
+{
+    u64 offset;
+    u64 count;
 };
 
 typedef struct Http_Response Http_Response;
@@ -238,6 +254,30 @@ struct Http_Response
     Http_Header_Array headers;
     String content_type;
     String body;
+
+    // NOTE(nick): preformatted header lines, sent instead of formatting Content-Type and Content-Length
+    // (except for partial responses, which always format their own)
+    String raw_headers;
+
+    // NOTE(nick): streamed from disk instead of sending body, see socket_send_file
+    String file_path;
+    u64 file_size;
+
+    // NOTE(nick): file_path already opened by the caller, so the bytes can't change between making the response
+    // and sending it. It's only read at explicit offsets, so connections can share it, and it has to stay open until done.
+    File *file;
+
+    // NOTE(nick): only send these parts of the body as a 206, see http_parse_ranges
+    Http_Range ranges[HTTP_MAX_RANGES];
+    i64 range_count;
+
+    // NOTE(nick): keep the connection open as a Server-Sent Events stream (see http_server_send_event)
+    bool event_stream;
+
+    // NOTE(nick): called once the response has been sent or dropped. Without it the server copies body,
+    // with it body and file_path only have to stay valid until it's called.
+    void (*done)(void *data);
+    void *done_data;
 };
 
 
@@ -275,9 +315,13 @@ function bool socket_listen(Socket *socket);
 function bool socket_accept(Socket *socket, Socket_Address *address);
 
 function bool socket_can_write(Socket *socket);
+function bool socket_wait(Socket *socket, bool for_writing, i64 timeout_ms);
 
 function bool socket_is_ready(Socket *socket);
 function bool socket_send(Socket *socket, Socket_Address address, String message);
+function bool socket_send_file(Socket *socket, String path, u64 offset, u64 size);
+function i64 socket_send_bytes(Socket *socket, u8 *data, u64 count);
+function i64 socket_send_file_bytes(Socket *socket, File *file, u64 offset, u64 count);
 function i64 socket_recieve_bytes(Socket *socket, u8 *data, u64 count, Socket_Address *address);
 function bool socket_recieve(Socket *socket, String *buffer, Socket_Address *address);
 
@@ -305,8 +349,15 @@ function void http_process(Http *http);
 
 
 function Http_Header_Array http_parse_headers(Arena *arena, String headers);
+function String http_find_header(String headers, String key);
+function i64 http_request_size(String buffer);
 function Http_Request http_parse_request(String request);
 
+function String http_date_string(Arena *arena, Date_Time date);
+function bool http_parse_date(String str, Date_Time *result);
+function bool http_etag_matches(String if_none_match, String etag);
+function i64 http_parse_ranges(String header, u64 size, Http_Range *ranges, i64 max_count);
+
 function void http_manager_init(Http_Manager *manager);
 function void http_manager_add(Http_Manager *manager, Http *request);
 function void http_manager_update(Http_Manager *manager);
@@ -360,6 +411,12 @@ static WSACleanup_Func *W32_WSACleanup;
 #include <arpa/inet.h>
 #include <sys/time.h>
 #include <sys/select.h>
+#include <poll.h>
+#include <signal.h>
+
+#if OS_LINUX
+#include <sys/sendfile.h>
+#endif
 
 #define SOCKET_ERROR   -1
 #define INVALID_SOCKET -1
@@ -474,6 +531,9 @@ function bool socket_init()
       print("WSAStartup failed: %d", W32_WSAGetLastError());
       return false;
     }
+    #else
+    // NOTE(nick): sendfile has no MSG_NOSIGNAL, so a client going away mid-file would kill the process
+    signal(SIGPIPE, SIG_IGN);
     #endif // OS_WINDOWS
 
     initted = true;
@@ -581,6 +641,11 @@ function bool socket_accept(Socket *socket, Socket *from_socket, Socket_Address
     {
         socket_set_non_blocking_internal(sock);
 
+        #ifdef SO_NOSIGPIPE
+        int no_sigpipe = 1;
+        setsockopt(sock, SOL_SOCKET, SO_NOSIGPIPE, (char *)&no_sigpipe, sizeof(no_sigpipe));
+        #endif
+
         if (from_address != NULL)
         {
             from_address->host = from.sin_addr.s_addr;
@@ -667,6 +732,33 @@ function bool socket_is_ready(Socket *socket)
     return result > 0;
 }
 
+// NOTE(nick): a negative timeout waits forever
+function bool socket_wait(Socket *socket, bool for_writing, i64 timeout_ms)
+{
+    if (!socket) return false;
+
+    #if OS_WINDOWS
+    fd_set fds;
+    FD_ZERO(&fds);
+    FD_SET(socket->handle, &fds);
+
+    struct timeval timeout;
+    timeout.tv_sec  = timeout_ms / 1000;
+    timeout.tv_usec = (timeout_ms % 1000) * 1000;
+
+    int result = select(0, for_writing ? NULL : &fds, for_writing ? &fds : NULL, NULL, timeout_ms < 0 ? NULL : &timeout);
+    #else
+    // NOTE(nick): poll instead of select because handles can be larger than FD_SETSIZE
+    struct pollfd pfd = {0};
+    pfd.fd     = socket->handle;
+    pfd.events = for_writing ? POLLOUT : POLLIN;
+
+    int result = poll(&pfd, 1, (int)timeout_ms);
+    #endif
+
+    return result > 0;
+}
+
 function bool socket_send(Socket *socket, Socket_Address address, String message)
 {
     if (!socket) return false;
@@ -689,19 +781,125 @@ function bool socket_send(Socket *socket, Socket_Address address, String message
     }
     else
     {
-        // @Incomplete: non-blocking TCP
-
-        int sent_bytes = send(socket->handle, (char *)message.data, message.count, 0);
-        if (sent_bytes != message.count)
+        // NOTE(nick): sockets are non-blocking, so big messages go out in pieces as the socket drains
+        i64 total_sent = 0;
+        while (total_sent < message.count)
         {
-            //return zed_net__error("Failed to send data");
-            return false;
+            i64 sent_bytes = socket_send_bytes(socket, message.data + total_sent, message.count - total_sent);
+            if (sent_bytes < 0)
+            {
+                if (SOCKET_LAST_ERROR() == SOCKET_WOULD_BLOCK && socket_wait(socket, true, 5000)) continue;
+
+                //return zed_net__error("Failed to send data");
+                return false;
+            }
+
+            total_sent += sent_bytes;
         }
 
         return true;
     }
 }
 
+// NOTE(nick): sends part of a file without ever holding all of it in memory
+function bool socket_send_file(Socket *socket, String path, u64 offset, u64 size)
+{
+    if (!socket) return false;
+
+    File file = os_file_open(path, FileMode_Read);
+    if (file.has_errors) return false;
+
+    bool result = true;
+    u64 at  = offset;
+    u64 end = offset + size;
+
+    while (at < end)
+    {
+        i64 sent_bytes = socket_send_file_bytes(socket, &file, at, end - at);
+        if (sent_bytes < 0)
+        {
+            if (SOCKET_LAST_ERROR() == SOCKET_WOULD_BLOCK && socket_wait(socket, true, 5000)) continue;
+
+            result = false;
+            break;
+        }
+
+        // NOTE(nick): the file got shorter since we were asked to send it
+        if (sent_bytes == 0)
+        {
+            result = false;
+            break;
+        }
+
+        at += sent_bytes;
+    }
+
+    os_file_close(&file);
+    return result;
+}
+
+// NOTE(nick): writes whatever fits right now, returns -1 with SOCKET_WOULD_BLOCK when the socket is full
+function i64 socket_send_bytes(Socket *socket, u8 *data, u64 count)
+{
+    if (!socket) return -1;
+
+    // NOTE(nick): writing to a client that has gone away should fail, not kill the process
+    int flags = 0;
+    #ifdef MSG_NOSIGNAL
+    flags = MSG_NOSIGNAL;
+    #endif
+
+    i64 sent_bytes;
+    do
+    {
+        sent_bytes = send(socket->handle, (char *)data, count, flags);
+    }
+    while (sent_bytes < 0 && SOCKET_LAST_ERROR() == EINTR);
+
+    return sent_bytes;
+}
+
+// NOTE(nick): same as socket_send_bytes, but from a file that is already open, 0 means the file ended early
+function i64 socket_send_file_bytes(Socket *socket, File *file, u64 offset, u64 count)
+{
+    if (!socket || !file->handle) return -1;
+
+    #if OS_LINUX
+    // NOTE(nick): the kernel copies straight from the page cache to the socket
+    int fd = fileno((FILE *)file->handle);
+    off_t at = offset;
+
+    ssize_t sent_bytes;
+    do
+    {
+        sent_bytes = sendfile(socket->handle, fd, &at, count);
+    }
+    while (sent_bytes < 0 && errno == EINTR);
+
+    return sent_bytes;
+    #else
+    // @Incomplete: TransmitFile on windows
+    M_Temp scratch = GetScratch(0, 0);
+
+    // NOTE(nick): whatever the socket didn't take is just read again next time
+    u64 chunk_size = Min(count, Kilobytes(64));
+    u8 *buffer = PushArray(scratch.arena, u8, chunk_size);
+
+    #if OS_WINDOWS
+    os_file_read(file, offset, chunk_size, buffer);
+    i64 read_bytes = file->has_errors ? 0 : chunk_size;
+    #else
+    // NOTE(nick): not os_file_read, pread leaves the file position alone so the file can be shared between connections
+    i64 read_bytes = pread(fileno((FILE *)file->handle), buffer, chunk_size, offset);
+    #endif
+
+    i64 result = read_bytes > 0 ? socket_send_bytes(socket, buffer, read_bytes) : 0;
+
+    ReleaseScratch(scratch);
+    return result;
+    #endif
+}
+
 function i64 socket_recieve_bytes(Socket *socket, u8 *data, u64 count, Socket_Address *address)
 {
     if (!socket) return false;
@@ -1132,37 +1330,226 @@ function void http_update(Http_Manager *manager)
 }
 
 
+// NOTE(nick): header names are case-insensitive, returns an empty string if the header isn't there
+function String http_find_header(String headers, String key)
+{
+    i64 index = 0;
+    while (index < headers.count)
+    {
+        i64 end = string_find(headers, S("\r\n"), index, 0);
+        String line = string_slice(headers, index, end);
+        index = end + 2;
+
+        i64 i = string_find(line, S(":"), 0, 0);
+        if (i < line.count && string_match(string_slice(line, 0, i), key, MatchFlag_IgnoreCase))
+        {
+            return string_trim_whitespace(string_slice(line, i + 1, line.count));
+        }
+    }
+
+    return {};
+}
+
+// NOTE(nick): size in bytes of the first request in buffer, 0 if we don't have all of it yet, -1 if it is malformed
+function i64 http_request_size(String buffer)
+{
+    i64 header_end = string_find(buffer, S("\r\n\r\n"), 0, 0);
+    if (header_end >= buffer.count) return 0;
+
+    String headers = string_slice(buffer, 0, header_end);
+
+    // @Incomplete: chunked request bodies
+    if (http_find_header(headers, S("Transfer-Encoding")).count) return -1;
+
+    i64 result = header_end + 4;
+
+    String content_length = http_find_header(headers, S("Content-Length"));
+    if (content_length.count)
+    {
+        i64 body_size = string_to_i64(content_length, 10);
+        if (body_size < 0) return -1;
+        result += body_size;
+    }
+
+    if (result > buffer.count) return 0;
+    return result;
+}
+
 function Http_Request http_parse_request(String request)
 {
     Http_Request result = {0};
 
-    i64 index;
+    i64 header_end = string_find(request, S("\r\n\r\n"), 0, 0);
+    String head = string_slice(request, 0, header_end);
+
+    i64 index = string_find(head, S("\r\n"), 0, 0);
+    String line = string_slice(head, 0, index);
+    result.headers = string_slice(head, index + 2, head.count);
+
+    index = string_find(line, S(" "), 0, 0);
+    if (index < line.count)
+    {
+        result.method = string_slice(line, 0, index);
+
+        i64 index2 = string_find(line, S(" "), index + 1, 0);
+        if (index2 < line.count)
+        {
+            result.url     = string_slice(line, index + 1, index2);
+            result.version = string_trim_whitespace(string_slice(line, index2 + 1, line.count));
+        }
+    }
+
+    // NOTE(nick): HTTP/1.1 connections stay open unless asked not to, HTTP/1.0 is the other way around
+    String connection = http_find_header(result.headers, S("Connection"));
+    if (string_equals(result.version, S("HTTP/1.1")))
+    {
+        result.keep_alive = string_find(connection, S("close"), 0, MatchFlag_IgnoreCase) >= connection.count;
+    }
+    else
+    {
+        result.keep_alive = string_find(connection, S("keep-alive"), 0, MatchFlag_IgnoreCase) < connection.count;
+    }
+
+    String content_length = http_find_header(result.headers, S("Content-Length"));
+    if (content_length.count)
+    {
+        i64 body_start = header_end + 4;
+        result.body = string_slice(request, body_start, body_start + string_to_i64(content_length, 10));
+    }
+
+    return result;
+}
+
+static const char *http_day_names   = "SunMonTueWedThuFriSat";
+static const char *http_month_names = "JanFebMarAprMayJunJulAugSepOctNovDec";
+
+// NOTE(nick): the IMF-fixdate format, e.g. "Sun, 06 Nov 1994 08:49:37 GMT"
+function String http_date_string(Arena *arena, Date_Time date)
+{
+    // NOTE(nick): Sakamoto's day of the week
+    static int offsets[] = {0, 3, 2, 5, 0, 3, 5, 1, 4, 6, 2, 4};
+    i32 y = date.mon < 3 ? date.year - 1 : date.year;
+    i32 day_of_week = (y + y/4 - y/100 + y/400 + offsets[date.mon - 1] + date.day) % 7;
+
+    return string_print(arena, "%.3s, %02d %.3s %04d %02d:%02d:%02d GMT",
+        http_day_names + 3 * day_of_week, date.day, http_month_names + 3 * (date.mon - 1), date.year,
+        date.hour, date.min, date.sec);
+}
 
-    index = string_find(request, S("\r\n"), 0, 0);
-    if (index < request.count)
+// @Incomplete: the obsolete RFC 850 and asctime formats
+function bool http_parse_date(String str, Date_Time *result)
+{
+    i64 comma = string_find(str, S(","), 0, 0);
+    if (comma >= str.count) return false;
+
+    // NOTE(nick): "06 Nov 1994 08:49:37 GMT"
+    String it = string_trim_whitespace(string_slice(str, comma + 1, str.count));
+    if (it.count < 20 || it.data[2] != ' ' || it.data[6] != ' ' || it.data[11] != ' ') return false;
+
+    String month_names = string_from_cstr((char *)http_month_names);
+    i64 month_index = string_find(month_names, string_slice(it, 3, 6), 0, 0);
+    if (month_index >= month_names.count || month_index % 3 != 0) return false;
+
+    Date_Time date = {0};
+    date.day  = (u8)string_to_i64(string_slice(it, 0, 2), 10);
+    date.mon  = (u8)(month_index / 3 + 1);
+    date.year = (i16)string_to_i64(string_slice(it, 7, 11), 10);
+    date.hour = (u8)string_to_i64(string_slice(it, 12, 14), 10);
+    date.min  = (u8)string_to_i64(string_slice(it, 15, 17), 10);
+    date.sec  = (u8)string_to_i64(string_slice(it, 18, 20), 10);
+
+    *result = date;
+    return true;
+}
+
+// NOTE(nick): If-None-Match is a comma separated list of (possibly weak) tags, or "*"
+function bool http_etag_matches(String if_none_match, String etag)
+{
+    if (string_equals(string_trim_whitespace(if_none_match), S("*"))) return true;
+
+    i64 index = 0;
+    while (index < if_none_match.count)
     {
-        request = string_slice(request, 0, index);
+        i64 end = string_find(if_none_match, S(","), index, 0);
+        String it = string_trim_whitespace(string_slice(if_none_match, index, end));
+        index = end + 1;
+
+        if (string_starts_with(it, S("W/"))) it = string_slice(it, 2, it.count);
+        if (string_equals(it, etag)) return true;
     }
 
-    index = string_find(request, S(" "), 0, 0);
-    if (index < request.count)
+    return false;
+}
+
+// NOTE(nick): returns how many ranges there are, 0 if the header should be ignored and -1 if none of them can be satisfied
+function i64 http_parse_ranges(String header, u64 size, Http_Range *ranges, i64 max_count)
+{
+    header = string_trim_whitespace(header);
+    if (!string_starts_with(header, S("bytes="))) return 0;
+
+    i64 count = 0;
+
+    i64 index = S("bytes=").count;
+    while (index < header.count)
     {
-        result.method = string_slice(request, 0, index);
+        i64 end = string_find(header, S(","), index, 0);
+        String it = string_trim_whitespace(string_slice(header, index, end));
+        index = end + 1;
+
+        if (!it.count) continue;
+
+        i64 dash = string_find(it, S("-"), 0, 0);
+        if (dash >= it.count) return 0;
+
+        String first = string_slice(it, 0, dash);
+        String last  = string_slice(it, dash + 1, it.count);
 
-        i64 index2 = string_find(request, S(" "), index + 1, 0);
-        if (index2 < request.count)
+        u64 first_byte = 0;
+        u64 last_byte  = 0;
+
+        if (!first.count)
+        {
+            // NOTE(nick): "-500" is the last 500 bytes
+            if (!last.count) return 0;
+
+            u64 suffix = Min((u64)string_to_i64(last, 10), size);
+            if (suffix == 0) continue;
+
+            first_byte = size - suffix;
+            last_byte  = size - 1;
+        }
+        else
         {
-            result.url = string_slice(request, index + 1, index2);
+            first_byte = string_to_i64(first, 10);
+            last_byte  = last.count ? string_to_i64(last, 10) : first_byte;
+
+            if (last_byte < first_byte) return 0;
+            if (first_byte >= size) continue;
+
+            last_byte = last.count ? Min(last_byte, size - 1) : size - 1;
         }
+
+        // NOTE(nick): too many pieces to bother with, just send the whole thing
+        if (count >= max_count) return 0;
+
+        ranges[count].offset = first_byte;
+        ranges[count].count  = last_byte - first_byte + 1;
+        count += 1;
     }
 
-    return result;
+    return count > 0 ? count : -1;
 }
 
 function Socket socket_create_tcp_server(Socket_Address address)
 {
     Socket result = socket_open(SocketType_TCP);
 
+    #if !OS_WINDOWS
+    // NOTE(nick): the server closes idle connections itself, so restarting it would otherwise have to wait out TIME_WAIT
+    int reuse_address = 1;
+    setsockopt(result.handle, SOL_SOCKET, SO_REUSEADDR, (char *)&reuse_address, sizeof(reuse_address));
+    #endif
+
     if (!socket_bind(&result, address))
     {
         String url = socket_get_address_name(address);
@@ -1228,6 +1615,7 @@ function String http_status_name_from_code(i32 status_code)
         case 413: { result = S("Payload Too Large"); } break;
         case 414: { result = S("URI Too Long"); } break;
         case 415: { result = S("Unsupported Media Type"); } break;
+        case 416: { result = S("Range Not Satisfiable"); } break;
 
         case 418: { result = S("I'm a teapot"); } break;
 
@@ -1279,110 +1667,640 @@ function String http_content_type_from_extension(String ext)
     return result;
 }
 
+#ifndef HTTP_EVENT_STREAM_MAX_PENDING
+#define HTTP_EVENT_STREAM_MAX_PENDING Kilobytes(16)
+#endif
+
+// NOTE(nick): pending is the end of the last message that the client hasn't read yet, it goes out before the next one
+typedef struct Http_Event_Stream Http_Event_Stream;
+struct Http_Event_Stream
+{
+    Http_Event_Stream *next;
+    Socket client;
+
+    u64 pending_count;
+    u8 pending[HTTP_EVENT_STREAM_MAX_PENDING];
+};
+
 typedef struct Http_Server Http_Server;
 struct Http_Server
 {
     Socket socket;
+
+    // NOTE(nick): idle event stream clients are just a socket in this list, they don't own a thread
+    Mutex mutex;
+    Http_Event_Stream *streams;
+    Http_Event_Stream *free_streams;
+
+    // NOTE(nick): held while sending events, so the list can be taken out from under mutex
+    Mutex send_mutex;
 };
 
 #define HTTP_REQUEST_CALLBACK(name) void name(Http_Request *request, Http_Response *response)
 typedef HTTP_REQUEST_CALLBACK(Http_Request_Callback);
 
-typedef struct Http_Thread_Params Http_Thread_Params;
-struct Http_Thread_Params
+#ifndef HTTP_MAX_REQUEST_SIZE
+#define HTTP_MAX_REQUEST_SIZE 8192
+#endif
+
+#ifndef HTTP_KEEP_ALIVE_TIMEOUT_MS
+#define HTTP_KEEP_ALIVE_TIMEOUT_MS 5000
+#endif
+
+// NOTE(nick): a piece of a response that hasn't been written yet, either bytes or a range of the response's file
+typedef struct Http_Send_Part Http_Send_Part;
+struct Http_Send_Part
 {
-    Socket client;
-    Socket_Address client_address;
-    Http_Request_Callback *request_handler;
+    String data;
+
+    bool from_file;
+    u64 offset;
+    u64 count;
 };
 
-THREAD_PROC(http_responder_thread)
+// NOTE(nick): the headers, then a part header and a body range for every range, then the closing boundary
+#define HTTP_MAX_SEND_PARTS (2 * HTTP_MAX_RANGES + 2)
+
+// NOTE(nick): bytes read from a client that haven't been answered yet, may hold several pipelined requests
+typedef struct Http_Connection Http_Connection;
+struct Http_Connection
 {
-    Http_Thread_Params *params = (Http_Thread_Params *)data;
-    Socket *client = &params->client;
+    // NOTE(nick): only used by the epoll server, for closing connections that have been waiting too long
+    Http_Connection *next;
+    Http_Connection *prev;
+    f64 watched_at;
+    i32 unsent_bytes;
 
-    String raw_request = socket_recieve_entire_stream(temp_arena(), client);
-    Http_Request request = http_parse_request(raw_request);
-    request.address = params->client_address;
+    Socket client;
+    Socket_Address address;
 
-    Http_Response response = {0};
-    params->request_handler(&request, &response);
+    u64 count;
+    u8 buffer[HTTP_MAX_REQUEST_SIZE];
 
-    if (!response.status_code) response.status_code = (response.body.count > 0) ? 200 : 500;
-    if (!response.content_type.count) response.content_type = S("text/plain");
+    // NOTE(nick): the response that is still being written, the next request waits until it's all out
+    Http_Response response;
+    bool keep_alive;
+    String owned; // NOTE(nick): the headers, and a copy of the body when nothing else keeps it alive
+    File file;
 
-    
-    M_Temp scratch = GetScratch(0, 0);
+    Http_Send_Part parts[HTTP_MAX_SEND_PARTS];
+    i64 part_index;
+    i64 part_count;
+};
 
-    String_Array chunks = {0};
-    chunks.data = PushArray(scratch.arena, String, 2048);
-    chunks.count = 0;
+typedef u32 Http_Connection_Status;
+enum
+{
+    HttpConnection_Open,
+    HttpConnection_Close,
 
-    String status_name = http_status_name_from_code(response.status_code);
-    String response_data = string_print(scratch.arena, "HTTP/1.0 %d %.*s\r\n", response.status_code, LIT(status_name));
-    chunks.data[chunks.count] = response_data;
-    chunks.count += 1;
+    // NOTE(nick): the socket belongs to the server's event streams now
+    HttpConnection_EventStream,
+
+    // NOTE(nick): the client isn't reading fast enough, wait until the socket can be written to again
+    HttpConnection_Blocked,
+};
+
+typedef u32 Http_Send_Status;
+enum
+{
+    HttpSend_Done,
+    HttpSend_Blocked,
+    HttpSend_Failed,
+};
+
+typedef struct Http_Thread_Params Http_Thread_Params;
+struct Http_Thread_Params
+{
+    Http_Server *server;
+    Socket client;
+    Socket_Address client_address;
+    Http_Request_Callback *request_handler;
+};
+
+function void http_server_add_event_stream(Http_Server *server, Socket client)
+{
+    mutex_aquire_lock(&server->mutex);
 
-    if (response.content_type.count)
+    Http_Event_Stream *stream = server->free_streams;
+    if (stream)
     {
-        chunks.data[chunks.count] = string_print(scratch.arena, "Content-Type: %.*s\r\n", LIT(response.content_type));
-        chunks.count += 1;
+        server->free_streams = stream->next;
     }
-
-    if (response.body.count)
+    else
     {
-        chunks.data[chunks.count] = string_print(scratch.arena, "Content-Length: %d\r\n", response.body.count);
-        chunks.count += 1;
+        stream = New(Http_Event_Stream, 1);
     }
 
-    if (response.headers.count > 0)
+    stream->client = client;
+    stream->pending_count = 0;
+    stream->next = server->streams;
+    server->streams = stream;
+
+    mutex_release_lock(&server->mutex);
+}
+
+// NOTE(nick): writes what the socket takes right now, and keeps the rest for next time
+function bool http_event_stream_write(Http_Event_Stream *stream, String data)
+{
+    if (stream->pending_count == 0)
     {
-        for (int index = 0; index < response.headers.count; index += 1)
+        i64 sent_bytes = socket_send_bytes(&stream->client, data.data, data.count);
+        if (sent_bytes < 0)
         {
-            Http_Header it = response.headers.data[index];
-
-            assert(chunks.count < 2048);
-            chunks.data[chunks.count] = string_print(scratch.arena, "%.*s: %.*s\r\n", LIT(it.key), LIT(it.value));
-            chunks.count += 1;
+            if (SOCKET_LAST_ERROR() != SOCKET_WOULD_BLOCK) return false;
+            sent_bytes = 0;
         }
-    }
 
-    assert(chunks.count < 2048);
-    chunks.data[chunks.count] = S("\r\n");
-    chunks.count += 1;
+        data = string_skip(data, sent_bytes);
+    }
 
-    String response_payload = string_concat_array(scratch.arena, chunks.data, chunks.count);
-    socket_send(client, {}, response_payload);
+    if (data.count == 0) return true;
 
-    if (response.body.count)
-    {
-        socket_send(client, {}, response.body);
-    }
+    // NOTE(nick): a client this far behind isn't reading the stream anymore
+    if (stream->pending_count + data.count > sizeof(stream->pending)) return false;
 
-    socket_close(client);
-    return 0;
+    MemoryCopy(stream->pending + stream->pending_count, data.data, data.count);
+    stream->pending_count += data.count;
+    return true;
 }
 
-function Http_Server http_server_init(String server_url)
+function bool http_event_stream_flush(Http_Event_Stream *stream)
 {
-    Http_Server result = {0};
-    Socket_Address address = socket_make_address_from_url(server_url);
-    result.socket = socket_create_tcp_server(address);
-    return result;
+    if (stream->pending_count == 0) return true;
+
+    i64 sent_bytes = socket_send_bytes(&stream->client, stream->pending, stream->pending_count);
+    if (sent_bytes < 0) return SOCKET_LAST_ERROR() == SOCKET_WOULD_BLOCK;
+
+    MemoryMove(stream->pending, stream->pending + sent_bytes, stream->pending_count - sent_bytes);
+    stream->pending_count -= sent_bytes;
+    return true;
 }
 
-function bool http_server_poll(Http_Server *server, Socket *client, Socket_Address *client_address)
+// NOTE(nick): one Server-Sent Event, several of them can be joined and sent at once with http_server_send_events
+function String http_event_message(Arena *arena, String event, String data)
 {
-    return socket_accept(&server->socket, client, client_address);
+    return string_print(arena, "event: %.*s\ndata: %.*s\n\n", LIT(event), LIT(data));
 }
 
-function void http_server_tick(Http_Server *server, Http_Request_Callback request_handler)
+// NOTE(nick): can be called from any thread, clients that have gone away or stopped reading are dropped here.
+// Accepted sockets are non-blocking, so a stalled client never holds this up.
+function void http_server_send_events(Http_Server *server, String message)
 {
-    Socket client;
-    Socket_Address client_address;
-    while (http_server_poll(server, &client, &client_address))
+    mutex_aquire_lock(&server->send_mutex);
+
+    // NOTE(nick): streams added while sending go on the server's list and get the next message
+    mutex_aquire_lock(&server->mutex);
+    Http_Event_Stream *streams = server->streams;
+    server->streams = NULL;
+    mutex_release_lock(&server->mutex);
+
+    Http_Event_Stream *kept = NULL;
+    Http_Event_Stream *dropped = NULL;
+
+    while (streams)
+    {
+        Http_Event_Stream *stream = streams;
+        streams = stream->next;
+
+        if (http_event_stream_flush(stream) && http_event_stream_write(stream, message))
+        {
+            stream->next = kept;
+            kept = stream;
+        }
+        else
+        {
+            socket_close(&stream->client);
+
+            stream->next = dropped;
+            dropped = stream;
+        }
+    }
+
+    mutex_aquire_lock(&server->mutex);
+
+    while (kept)
+    {
+        Http_Event_Stream *stream = kept;
+        kept = stream->next;
+        stream->next = server->streams;
+        server->streams = stream;
+    }
+
+    while (dropped)
+    {
+        Http_Event_Stream *stream = dropped;
+        dropped = stream->next;
+        stream->next = server->free_streams;
+        server->free_streams = stream;
+    }
+
+    mutex_release_lock(&server->mutex);
+
+    mutex_release_lock(&server->send_mutex);
+}
+
+function void http_server_send_event(Http_Server *server, String event, String data)
+{
+    M_Temp scratch = GetScratch(0, 0);
+    http_server_send_events(server, http_event_message(scratch.arena, event, data));
+    ReleaseScratch(scratch);
+}
+
+function String http_copy_into(u8 **at, String str)
+{
+    String result = string_make(*at, str.count);
+    MemoryCopy(result.data, str.data, str.count);
+    *at += str.count;
+    return result;
+}
+
+function void http_connection_push(Http_Connection *conn, String data)
+{
+    assert(conn->part_count < count_of(conn->parts));
+
+    Http_Send_Part *part = &conn->parts[conn->part_count];
+    MemoryZeroStruct(part);
+    part->data = data;
+    conn->part_count += 1;
+}
+
+function void http_connection_push_body(Http_Connection *conn, String body, u64 offset, u64 count)
+{
+    if (conn->response.file_path.count)
+    {
+        assert(conn->part_count < count_of(conn->parts));
+
+        Http_Send_Part *part = &conn->parts[conn->part_count];
+        MemoryZeroStruct(part);
+        part->from_file = true;
+        part->offset    = offset;
+        part->count     = count;
+        conn->part_count += 1;
+        return;
+    }
+
+    http_connection_push(conn, string_substr(body, offset, count));
+}
+
+// NOTE(nick): runs the handler and queues up the response on the connection, see http_connection_flush
+function void http_server_respond(Http_Server *server, Http_Connection *conn, Http_Request *request, Http_Request_Callback *request_handler)
+{
+    Http_Response response = {0};
+    request_handler(request, &response);
+
+    if (response.event_stream)
+    {
+        response.status_code  = 200;
+        response.content_type = S("text/event-stream");
+    }
+
+    if (!response.status_code) response.status_code = (response.body.count > 0 || response.file_path.count > 0) ? 200 : 500;
+    if (!response.content_type.count) response.content_type = S("text/plain");
+
+    u64 content_size = response.file_path.count ? response.file_size : response.body.count;
+    if (response.range_count > 0) response.status_code = 206;
+
+
+    M_Temp scratch = GetScratch(0, 0);
+
+    String_Array chunks = {0};
+    chunks.data = PushArray(scratch.arena, String, 2048);
+    chunks.count = 0;
+
+    String status_name = http_status_name_from_code(response.status_code);
+    String response_data = string_print(scratch.arena, "HTTP/1.1 %d %.*s\r\n", response.status_code, LIT(status_name));
+    chunks.data[chunks.count] = response_data;
+    chunks.count += 1;
+
+    if (!response.event_stream)
+    {
+        chunks.data[chunks.count] = request->keep_alive ? S("Connection: keep-alive\r\n") : S("Connection: close\r\n");
+        chunks.count += 1;
+    }
+
+    // NOTE(nick): every part of a multi-range response starts with its own little header
+    String boundary = S("na_net_byteranges");
+    String part_headers[HTTP_MAX_RANGES];
+
+    if (response.range_count == 1)
+    {
+        Http_Range range = response.ranges[0];
+
+        chunks.data[chunks.count] = string_print(scratch.arena, "Content-Type: %.*s\r\nContent-Range: bytes %llu-%llu/%llu\r\nContent-Length: %llu\r\n",
+            LIT(response.content_type), range.offset, range.offset + range.count - 1, content_size, range.count);
+        chunks.count += 1;
+    }
+    else if (response.range_count > 1)
+    {
+        u64 content_length = 0;
+        for (i64 i = 0; i < response.range_count; i += 1)
+        {
+            Http_Range range = response.ranges[i];
+
+            part_headers[i] = string_print(scratch.arena, "\r\n--%.*s\r\nContent-Type: %.*s\r\nContent-Range: bytes %llu-%llu/%llu\r\n\r\n",
+                LIT(boundary), LIT(response.content_type), range.offset, range.offset + range.count - 1, content_size);
+
+            content_length += part_headers[i].count + range.count;
+        }
+        content_length += S("\r\n--").count + boundary.count + S("--\r\n").count;
+
+        chunks.data[chunks.count] = string_print(scratch.arena, "Content-Type: multipart/byteranges; boundary=%.*s\r\nContent-Length: %llu\r\n",
+            LIT(boundary), content_length);
+        chunks.count += 1;
+    }
+
+    if (response.raw_headers.count)
+    {
+        chunks.data[chunks.count] = response.raw_headers;
+        chunks.count += 1;
+    }
+    else if (response.range_count == 0)
+    {
+        if (response.content_type.count)
+        {
+            chunks.data[chunks.count] = string_print(scratch.arena, "Content-Type: %.*s\r\n", LIT(response.content_type));
+            chunks.count += 1;
+        }
+
+        if (response.event_stream)
+        {
+            chunks.data[chunks.count] = S("Cache-Control: no-cache\r\n");
+            chunks.count += 1;
+        }
+        else
+        {
+            // NOTE(nick): always sent, the client needs it to find where the next response starts
+            chunks.data[chunks.count] = string_print(scratch.arena, "Content-Length: %llu\r\n", content_size);
+            chunks.count += 1;
+        }
+    }
+
+    if (response.headers.count > 0)
+    {
+        for (int index = 0; index < response.headers.count; index += 1)
+        {
+            Http_Header it = response.headers.data[index];
+
+            assert(chunks.count < 2048);
+            chunks.data[chunks.count] = string_print(scratch.arena, "%.*s: %.*s\r\n", LIT(it.key), LIT(it.value));
+            chunks.count += 1;
+        }
+    }
+
+    assert(chunks.count < 2048);
+    chunks.data[chunks.count] = S("\r\n");
+    chunks.count += 1;
+
+    String head = string_concat_array(scratch.arena, chunks.data, chunks.count);
+
+    String trailer = {0};
+    if (response.range_count > 1) trailer = string_print(scratch.arena, "\r\n--%.*s--\r\n", LIT(boundary));
+
+    bool send_body = !string_equals(request->method, S("HEAD"));
+    bool copy_body = send_body && !response.done && !response.file_path.count;
+
+    // NOTE(nick): the response can go out long after the request is gone, so the connection keeps its own copy
+    // of everything that isn't kept alive by the done callback
+    u64 owned_size = head.count + trailer.count;
+    if (copy_body) owned_size += response.body.count;
+    if (!response.done) owned_size += response.file_path.count;
+    for (i64 i = 0; i < response.range_count && response.range_count > 1; i += 1) owned_size += part_headers[i].count;
+
+    u8 *at = (u8 *)os_alloc(Max(owned_size, 1));
+    conn->owned = string_make(at, owned_size);
+
+    String body = response.body;
+    if (copy_body) body = http_copy_into(&at, body);
+    if (!response.done) response.file_path = http_copy_into(&at, response.file_path);
+
+    conn->response   = response;
+    conn->keep_alive = request->keep_alive;
+    conn->part_index = 0;
+    conn->part_count = 0;
+
+    http_connection_push(conn, http_copy_into(&at, head));
+
+    if (send_body)
+    {
+        if (response.range_count == 1)
+        {
+            http_connection_push_body(conn, body, response.ranges[0].offset, response.ranges[0].count);
+        }
+        else if (response.range_count > 1)
+        {
+            for (i64 i = 0; i < response.range_count; i += 1)
+            {
+                http_connection_push(conn, http_copy_into(&at, part_headers[i]));
+                http_connection_push_body(conn, body, response.ranges[i].offset, response.ranges[i].count);
+            }
+
+            http_connection_push(conn, http_copy_into(&at, trailer));
+        }
+        else if (content_size > 0)
+        {
+            http_connection_push_body(conn, body, 0, content_size);
+        }
+    }
+
+    ReleaseScratch(scratch);
+}
+
+// NOTE(nick): writes as much of the pending response as the socket takes without blocking
+function Http_Send_Status http_connection_flush(Http_Connection *conn)
+{
+    while (conn->part_index < conn->part_count)
+    {
+        Http_Send_Part *part = &conn->parts[conn->part_index];
+
+        u64 remaining = part->from_file ? part->count : part->data.count;
+        if (remaining == 0)
+        {
+            conn->part_index += 1;
+            continue;
+        }
+
+        i64 sent_bytes = 0;
+        if (part->from_file)
+        {
+            File *file = conn->response.file;
+            if (!file)
+            {
+                if (!conn->file.handle)
+                {
+                    conn->file = os_file_open(conn->response.file_path, FileMode_Read);
+                    if (conn->file.has_errors) return HttpSend_Failed;
+                }
+
+                file = &conn->file;
+            }
+
+            sent_bytes = socket_send_file_bytes(&conn->client, file, part->offset, part->count);
+        }
+        else
+        {
+            sent_bytes = socket_send_bytes(&conn->client, part->data.data, part->data.count);
+        }
+
+        if (sent_bytes < 0)
+        {
+            return SOCKET_LAST_ERROR() == SOCKET_WOULD_BLOCK ? HttpSend_Blocked : HttpSend_Failed;
+        }
+
+        // NOTE(nick): the file got shorter since the response was made
+        if (sent_bytes == 0) return HttpSend_Failed;
+
+        if (part->from_file)
+        {
+            part->offset += sent_bytes;
+            part->count  -= sent_bytes;
+        }
+        else
+        {
+            part->data = string_skip(part->data, sent_bytes);
+        }
+    }
+
+    return HttpSend_Done;
+}
+
+function void http_connection_end_response(Http_Connection *conn)
+{
+    if (conn->response.done) conn->response.done(conn->response.done_data);
+
+    os_file_close(&conn->file);
+    os_free(conn->owned.data);
+
+    MemoryZeroStruct(&conn->response);
+    MemoryZeroStruct(&conn->file);
+    conn->owned      = {0};
+    conn->part_index = 0;
+    conn->part_count = 0;
+}
+
+function void http_connection_free(Http_Connection *conn)
+{
+    if (conn->part_count) http_connection_end_response(conn);
+    os_free(conn);
+}
+
+// NOTE(nick): answers every complete request in the connection buffer in order, and keeps any partial one around for the next read
+function Http_Connection_Status http_server_process(Http_Server *server, Http_Connection *conn, Http_Request_Callback *request_handler)
+{
+    for (;;)
+    {
+        if (conn->part_count)
+        {
+            Http_Send_Status sent = http_connection_flush(conn);
+            if (sent == HttpSend_Blocked) return HttpConnection_Blocked;
+
+            bool event_stream = conn->response.event_stream;
+            bool keep_alive   = conn->keep_alive;
+            http_connection_end_response(conn);
+
+            if (sent == HttpSend_Failed) return HttpConnection_Close;
+
+            if (event_stream)
+            {
+                http_server_add_event_stream(server, conn->client);
+                return HttpConnection_EventStream;
+            }
+
+            if (!keep_alive) return HttpConnection_Close;
+        }
+
+        String buffer = string_make(conn->buffer, conn->count);
+
+        i64 size = http_request_size(buffer);
+        if (size < 0) return HttpConnection_Close;
+        if (size == 0)
+        {
+            // @Incomplete: 431 Request Header Fields Too Large
+            if (conn->count >= sizeof(conn->buffer)) return HttpConnection_Close;
+            return HttpConnection_Open;
+        }
+
+        M_Temp temp = arena_begin_temp(temp_arena());
+
+        Http_Request request = http_parse_request(string_slice(buffer, 0, size));
+        request.address = conn->address;
+
+        http_server_respond(server, conn, &request, request_handler);
+
+        arena_end_temp(temp);
+
+        MemoryMove(conn->buffer, conn->buffer + size, conn->count - size);
+        conn->count -= size;
+    }
+}
+
+THREAD_PROC(http_responder_thread)
+{
+    Http_Thread_Params *params = (Http_Thread_Params *)data;
+
+    Http_Connection *conn = New(Http_Connection, 1);
+    conn->client  = params->client;
+    conn->address = params->client_address;
+    conn->count   = 0;
+
+    Http_Connection_Status status = HttpConnection_Close;
+
+    // NOTE(nick): wait on the socket instead of reading to EOF, so kept-alive clients are answered straight away
+    while (socket_wait(&conn->client, false, HTTP_KEEP_ALIVE_TIMEOUT_MS))
+    {
+        i64 count = socket_recieve_bytes(&conn->client, conn->buffer + conn->count, sizeof(conn->buffer) - conn->count, NULL);
+        if (count == 0) break;
+
+        if (count < 0)
+        {
+            if (SOCKET_LAST_ERROR() == SOCKET_WOULD_BLOCK) continue;
+            break;
+        }
+
+        conn->count += count;
+
+        status = http_server_process(params->server, conn, params->request_handler);
+        while (status == HttpConnection_Blocked && socket_wait(&conn->client, true, HTTP_KEEP_ALIVE_TIMEOUT_MS))
+        {
+            status = http_server_process(params->server, conn, params->request_handler);
+        }
+
+        if (status != HttpConnection_Open) break;
+    }
+
+    if (status != HttpConnection_EventStream)
+    {
+        socket_close(&conn->client);
+    }
+
+    http_connection_free(conn);
+
+    return 0;
+}
+
+function Http_Server http_server_init(String server_url)
+{
+    Http_Server result = {0};
+    Socket_Address address = socket_make_address_from_url(server_url);
+    result.socket     = socket_create_tcp_server(address);
+    result.mutex      = mutex_create(0);
+    result.send_mutex = mutex_create(0);
+    return result;
+}
+
+function bool http_server_poll(Http_Server *server, Socket *client, Socket_Address *client_address)
+{
+    return socket_accept(&server->socket, client, client_address);
+}
+
+function void http_server_tick(Http_Server *server, Http_Request_Callback request_handler)
+{
+    Socket client;
+    Socket_Address client_address;
+    while (http_server_poll(server, &client, &client_address))
     {
         Http_Thread_Params params = {0};
+        params.server = server;
         params.client = client;
         params.client_address = client_address;
         params.request_handler = request_handler;
@@ -1393,6 +2311,279 @@ function void http_server_tick(Http_Server *server, Http_Request_Callback reques
     }
 }
 
+#if OS_LINUX
+
+//
+// Linux epoll server
+//
+// Every worker thread waits on the same epoll instance. Client sockets are edge-triggered and
+// one-shot, so only one thread ever touches a connection at a time, and a connection that is
+// still waiting on the rest of its request (or on the client to read its response) doesn't tie
+// up a thread.
+//
+// Connections that are waiting sit on an idle list. Once they've waited longer than
+// HTTP_KEEP_ALIVE_TIMEOUT_MS their socket is shut down, and the hang up wakes a worker to close it.
+//
+
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/ioctl.h>
+#include <linux/sockios.h>
+
+#ifndef HTTP_SERVER_WORKER_COUNT
+#define HTTP_SERVER_WORKER_COUNT 8
+#endif
+
+typedef struct Http_Epoll_Params Http_Epoll_Params;
+struct Http_Epoll_Params
+{
+    Http_Server *server;
+    Http_Request_Callback *request_handler;
+    int epoll_fd;
+
+    Mutex mutex;
+    Http_Connection *first_idle;
+    Http_Connection *last_idle;
+    f64 next_idle_check;
+};
+
+function void http_epoll_close(Http_Epoll_Params *params, Http_Connection *conn)
+{
+    epoll_ctl(params->epoll_fd, EPOLL_CTL_DEL, conn->client.handle, NULL);
+    socket_close(&conn->client);
+    http_connection_free(conn);
+}
+
+function void http_epoll_unwatch(Http_Epoll_Params *params, Http_Connection *conn)
+{
+    mutex_aquire_lock(&params->mutex);
+    DLLRemove(params->first_idle, params->last_idle, conn);
+    mutex_release_lock(&params->mutex);
+}
+
+function bool http_epoll_watch(Http_Epoll_Params *params, Http_Connection *conn, int op, bool for_writing)
+{
+    // NOTE(nick): has to be on the idle list before another worker can be handed the connection
+    mutex_aquire_lock(&params->mutex);
+    conn->watched_at   = os_time();
+    conn->unsent_bytes = 0;
+    if (for_writing) ioctl(conn->client.handle, SIOCOUTQ, &conn->unsent_bytes);
+    DLLPushBack(params->first_idle, params->last_idle, conn);
+    mutex_release_lock(&params->mutex);
+
+    struct epoll_event event = {0};
+    event.events   = (for_writing ? EPOLLOUT : EPOLLIN) | EPOLLET | EPOLLONESHOT;
+    event.data.ptr = conn;
+
+    if (epoll_ctl(params->epoll_fd, op, conn->client.handle, &event) == 0) return true;
+
+    http_epoll_unwatch(params, conn);
+    return false;
+}
+
+// NOTE(nick): the idle list is in the order connections started waiting, so this stops at the first one that hasn't timed out
+function void http_epoll_close_idle(Http_Epoll_Params *params)
+{
+    f64 now = os_time();
+
+    mutex_aquire_lock(&params->mutex);
+
+    if (now >= params->next_idle_check)
+    {
+        params->next_idle_check = now + 1.0;
+
+        Http_Connection *conn = params->first_idle;
+        while (conn && now - conn->watched_at >= HTTP_KEEP_ALIVE_TIMEOUT_MS / 1000.0)
+        {
+            Http_Connection *next = conn->next;
+
+            // NOTE(nick): a slow client that is still reading isn't idle, even if the socket hasn't drained enough to wake us up yet
+            int unsent_bytes = 0;
+            if (conn->unsent_bytes > 0 && ioctl(conn->client.handle, SIOCOUTQ, &unsent_bytes) == 0 && unsent_bytes < conn->unsent_bytes)
+            {
+                conn->watched_at   = now;
+                conn->unsent_bytes = unsent_bytes;
+                DLLRemove(params->first_idle, params->last_idle, conn);
+                DLLPushBack(params->first_idle, params->last_idle, conn);
+            }
+            else
+            {
+                // NOTE(nick): only the worker that gets the hang up frees the connection, so it's never freed under another thread
+                shutdown(conn->client.handle, SHUT_RDWR);
+            }
+
+            conn = next;
+        }
+    }
+
+    mutex_release_lock(&params->mutex);
+}
+
+function void http_epoll_accept(Http_Epoll_Params *params)
+{
+    Socket client;
+    Socket_Address client_address;
+    while (socket_accept(&params->server->socket, &client, &client_address))
+    {
+        Http_Connection *conn = New(Http_Connection, 1);
+        conn->client  = client;
+        conn->address = client_address;
+        conn->count   = 0;
+
+        if (!http_epoll_watch(params, conn, EPOLL_CTL_ADD, false))
+        {
+            socket_close(&conn->client);
+            http_connection_free(conn);
+        }
+    }
+}
+
+function void http_epoll_serve(Http_Epoll_Params *params, Http_Connection *conn)
+{
+    bool closed = false;
+
+    // NOTE(nick): edge-triggered, so we have to drain the socket before waiting on it again
+    for (;;)
+    {
+        Http_Connection_Status status = http_server_process(params->server, conn, params->request_handler);
+
+        if (status == HttpConnection_Blocked)
+        {
+            // NOTE(nick): give the thread back, we'll pick up where we left off once the client has read some of it
+            if (!http_epoll_watch(params, conn, EPOLL_CTL_MOD, true)) http_epoll_close(params, conn);
+            return;
+        }
+
+        if (status == HttpConnection_EventStream)
+        {
+            epoll_ctl(params->epoll_fd, EPOLL_CTL_DEL, conn->client.handle, NULL);
+            http_connection_free(conn);
+            return;
+        }
+
+        if (status == HttpConnection_Close || closed)
+        {
+            http_epoll_close(params, conn);
+            return;
+        }
+
+        i64 count = socket_recieve_bytes(&conn->client, conn->buffer + conn->count, sizeof(conn->buffer) - conn->count, NULL);
+        if (count == 0)
+        {
+            // NOTE(nick): still answer whatever the client sent before it hung up
+            closed = true;
+            continue;
+        }
+
+        if (count < 0)
+        {
+            if (SOCKET_LAST_ERROR() == SOCKET_WOULD_BLOCK) break;
+
+            http_epoll_close(params, conn);
+            return;
+        }
+
+        conn->count += count;
+    }
+
+    if (!http_epoll_watch(params, conn, EPOLL_CTL_MOD, false))
+    {
+        http_epoll_close(params, conn);
+    }
+}
+
+THREAD_PROC(http_epoll_worker)
+{
+    Http_Epoll_Params *params = (Http_Epoll_Params *)data;
+
+    struct epoll_event events[64];
+
+    for (;;)
+    {
+        // NOTE(nick): wake up every so often even without any events, to close idle connections
+        int count = epoll_wait(params->epoll_fd, events, count_of(events), 1000);
+
+        for (int i = 0; i < count; i += 1)
+        {
+            Http_Connection *conn = (Http_Connection *)events[i].data.ptr;
+
+            if (conn == NULL)
+            {
+                http_epoll_accept(params);
+                continue;
+            }
+
+            http_epoll_unwatch(params, conn);
+
+            if (events[i].events & (EPOLLERR | EPOLLHUP))
+            {
+                http_epoll_close(params, conn);
+            }
+            else
+            {
+                http_epoll_serve(params, conn);
+            }
+        }
+
+        http_epoll_close_idle(params);
+    }
+
+    return 0;
+}
+
+function void http_server_serve(Http_Server *server, Http_Request_Callback request_handler)
+{
+    // NOTE(nick): every open connection is a file descriptor, so use as many as we are allowed
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max)
+    {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    Http_Epoll_Params params = {0};
+    params.server          = server;
+    params.request_handler = request_handler;
+    params.epoll_fd        = epoll_create1(EPOLL_CLOEXEC);
+    params.mutex           = mutex_create(0);
+
+    if (params.epoll_fd < 0)
+    {
+        print("[http] Failed to create epoll instance\n");
+        return;
+    }
+
+    // NOTE(nick): the listening socket is the only one without a connection pointer
+    struct epoll_event event = {0};
+    event.events   = EPOLLIN | EPOLLET;
+    event.data.ptr = NULL;
+    epoll_ctl(params.epoll_fd, EPOLL_CTL_ADD, server->socket.handle, &event);
+
+    // NOTE(nick): the calling thread is one of the workers
+    for (int i = 1; i < HTTP_SERVER_WORKER_COUNT; i += 1)
+    {
+        Thread thread = thread_create(http_epoll_worker, &params, 0);
+        thread_detach(thread);
+    }
+
+    http_epoll_worker(&params);
+}
+
+#else
+
+// @Incomplete: use kqueue on MacOS and IOCP on windows
+function void http_server_serve(Http_Server *server, Http_Request_Callback request_handler)
+{
+    while (1)
+    {
+        arena_reset(temp_arena());
+        http_server_tick(server, request_handler);
+        socket_wait(&server->socket, false, 1000);
+    }
+}
+
+#endif // OS_LINUX
+
 function void http_server_run(String server_url, Http_Request_Callback request_handler)
 {
     socket_init();
@@ -1404,12 +2595,7 @@ function void http_server_run(String server_url, Http_Request_Callback request_h
         return;
     }
 
-    while (1)
-    {
-        arena_reset(temp_arena());
-        http_server_tick(&server, request_handler);
-        os_sleep(1);
-    }
+    http_server_serve(&server, request_handler);
 }
 
 #endif // impl
\ No newline at end of file